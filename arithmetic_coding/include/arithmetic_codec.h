@@ -0,0 +1,108 @@
+/*
+ * The header file for the arithmetic coding codec. It wraps RelationCompressor and
+ * RelationDecompressor of this library into the codec interface of db_compress, so that
+ * arithmetic coding can be picked at runtime next to delayed coding and rANS.
+ *
+ * Headers of db_compress share their file names with headers of this library, so they are
+ * included with angle brackets, i.e. from the include directory of db_compress.
+ */
+
+#ifndef ARITH_ARITHMETIC_CODEC_H
+#define ARITH_ARITHMETIC_CODEC_H
+
+#include <codec.h>
+#include <model_learner.h>
+
+#include <memory>
+#include <vector>
+
+namespace db_compress::arith {
+
+class RelationCompressor;
+class RelationDecompressor;
+struct AttrVector;
+
+/**
+ * Check whether arithmetic coding can encode every attribute of a schema, i.e. enum, integer,
+ * double and string attributes. Compressors and decompressors throw BlitzcrankException
+ * otherwise.
+ *
+ * @param schema schema contains attributes types
+ * @return true if every attribute type is supported
+ */
+bool IsSupportedSchema(const ::db_compress::Schema &schema);
+
+/**
+ * Arithmetic coding compressor. Models and attribute interpreters of this library are
+ * registered once it is created, the interpreters delegate to the ones registered in
+ * db_compress. Tuples are converted to the tuple type of this library one by one.
+ */
+class ArithmeticCompressor : public ::db_compress::TupleCompressor {
+ public:
+  /**
+   * Create a new arithmetic coding compressor.
+   *
+   * @param output_file address of compressed file, it is user specified
+   * @param schema attributes types and ordering are recorded in schema
+   * @param config learning config
+   * @param block_size number of tuples in a block of the index
+   */
+  ArithmeticCompressor(const char *output_file, const ::db_compress::Schema &schema,
+                       const ::db_compress::CompressionConfig &config, int block_size);
+  ~ArithmeticCompressor() override;
+
+  bool RequireFullPass() const override;
+  bool RequireMoreIterationsForLearning() const override;
+  void LearnTuple(const ::db_compress::AttrVector &tuple) override;
+  void CompressTuple(::db_compress::AttrVector &tuple) override;
+  void SetEnumDictionaries(const std::vector<::db_compress::BiMap> &dicts) override;
+  void EndOfLearning() override;
+  void EndOfCompress() override;
+
+ private:
+  std::unique_ptr<RelationCompressor> compressor_;
+  std::unique_ptr<AttrVector> tuple_;
+};
+
+/**
+ * Arithmetic coding decompressor, it decodes tuples one by one.
+ */
+class ArithmeticDecompressor : public ::db_compress::TupleDecompressor {
+ public:
+  /**
+   * Create a new arithmetic coding decompressor.
+   *
+   * @param compressed_file_name compressed file address
+   * @param schema schema contains attributes types and ordering
+   * @param block_size number of tuples in a block of the index
+   */
+  ArithmeticDecompressor(const char *compressed_file_name, const ::db_compress::Schema &schema,
+                         int block_size);
+  ~ArithmeticDecompressor() override;
+
+  void Init() override;
+  int GetNumTotalTuples() const override;
+  const std::vector<::db_compress::BiMap> &GetEnumDictionaries() const override {
+    return enum_dicts_;
+  }
+  void LocateTuple(uint32_t tuple_idx) override;
+  void ReadNextTuple(::db_compress::AttrVector *tuple) override;
+  bool HasNext() const override;
+
+  /**
+   * Decompress the whole dataset with one thread, num_threads is ignored.
+   */
+  void ParallelScan(
+      int num_threads,
+      const std::function<void(int, size_t, const ::db_compress::AttrVector &)> &callback) override;
+
+ private:
+  std::unique_ptr<RelationDecompressor> decompressor_;
+  std::unique_ptr<AttrVector> tuple_;
+  size_t num_attrs_;
+  std::vector<::db_compress::BiMap> enum_dicts_;
+};
+
+}  // namespace db_compress::arith
+
+#endif  // ARITH_ARITHMETIC_CODEC_H
@@ -2,8 +2,8 @@
  * The base header files that defines several basic structures
  */
 
-#ifndef BASE_H
-#define BASE_H
+#ifndef ARITH_BASE_H
+#define ARITH_BASE_H
 
 #include <iostream>
 #include <string>
@@ -12,11 +12,15 @@
 #include <vector>
 #include <unordered_map>
 #define kNonFullPassStopPoint 20000
+// Container header of compressed files, i.e. magic, version and codec id. It must match db_compress.
+#define kContainerMagic 0x424C5A43
+#define kContainerVersion 6
+#define kArithmeticCodingBackend 2
 // Numeric Model
 #define kNumBranch 512
 #define kNumEstSample 5000
 
-namespace db_compress {
+namespace db_compress::arith {
 /**
  * AttrValue is a union of possible values type. It is defined as union instead
  * of virtual class to avoid function call.
@@ -166,5 +170,5 @@ struct BiMap {
   std::vector<std::string> enums;
   std::unordered_map<std::string, int> enum2idx;
 };
-}  // namespace db_compress
+}  // namespace db_compress::arith
 #endif
@@ -2,8 +2,8 @@
  * The header file for categorical SquID and SquIDModel
  */
 
-#ifndef CATEGORICAL_MODEL_H
-#define CATEGORICAL_MODEL_H
+#ifndef ARITH_CATEGORICAL_MODEL_H
+#define ARITH_CATEGORICAL_MODEL_H
 
 #include <vector>
 
@@ -11,7 +11,7 @@
 #include "model.h"
 #include "utility.h"
 
-namespace db_compress {
+namespace db_compress::arith {
 /**
  * Statistic of one specific categorical attribute, consists of a histogram and
  * delayed coding components.
@@ -216,6 +216,6 @@ class TableCategoricalCreator : public ModelCreator {
   const size_t kMaxTableSize = 1000;
 };
 
-}  // namespace db_compress
+}  // namespace db_compress::arith
 
 #endif
@@ -1,7 +1,7 @@
 // The compression process class header
 
-#ifndef COMPRESSION_H
-#define COMPRESSION_H
+#ifndef ARITH_COMPRESSION_H
+#define ARITH_COMPRESSION_H
 
 #include <memory>
 #include <vector>
@@ -12,7 +12,7 @@
 #include "model.h"
 #include "model_learner.h"
 
-namespace db_compress {
+namespace db_compress::arith {
 
 /**
  * The meaning of stages are as follows:
@@ -69,6 +69,13 @@ class RelationCompressor {
    */
   void CompressTuple(AttrVector &tuple);
 
+  /**
+   * Enum dictionaries are stored in the compressed file, next to models.
+   *
+   * @param dicts enum values of each attribute
+   */
+  void SetEnumDictionaries(const std::vector<BiMap> &dicts) { enum_dicts_ = dicts; }
+
   /**
    * Learning stage ends, write down models.
    */
@@ -83,8 +90,9 @@ class RelationCompressor {
   Schema schema_;
   std::unique_ptr<ModelLearner> learner_;
   size_t num_tuples_;
-  IndexCreator index_creator_;
   std::string output_file_;
+  IndexCreator index_creator_;
+  std::vector<BiMap> enum_dicts_;
   const int kBlockSizeThreshold_;
   int compressor_stage_;
 
@@ -110,6 +118,6 @@ class RelationCompressor {
    */
   void CheckBlockInfo();
 };
-}  // namespace db_compress
+}  // namespace db_compress::arith
 
 #endif
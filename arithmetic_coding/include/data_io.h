@@ -1,5 +1,5 @@
-#ifndef DATA_IO_H
-#define DATA_IO_H
+#ifndef ARITH_DATA_IO_H
+#define ARITH_DATA_IO_H
 
 #include <fstream>
 #include <iostream>
@@ -7,7 +7,7 @@
 
 #include "base.h"
 
-namespace db_compress {
+namespace db_compress::arith {
 
 /**
  * SequenceByteWriter is a utility class that can be used to write bit strings
@@ -154,6 +154,6 @@ class ByteReader {
   unsigned int buffer_, buffer_len_;
 };
 
-}  // namespace db_compress
+}  // namespace db_compress::arith
 
 #endif
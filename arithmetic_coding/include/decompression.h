@@ -1,7 +1,7 @@
 // The decompression process class header
 
-#ifndef DECOMPRESSION_H
-#define DECOMPRESSION_H
+#ifndef ARITH_DECOMPRESSION_H
+#define ARITH_DECOMPRESSION_H
 
 #include <fstream>
 #include <memory>
@@ -13,7 +13,7 @@
 #include "index.h"
 #include "model.h"
 
-namespace db_compress {
+namespace db_compress::arith {
 
 /**
  * It is used to recovered information from compressed binary file.
@@ -71,6 +71,13 @@ class RelationDecompressor {
    */
   int GetCurrentPosition() const { return tuple_idx_ + num_converted_tuples_ - 1; }
 
+  /**
+   * Get enum dictionaries stored in the compressed file.
+   *
+   * @return enum values of each attribute
+   */
+  const std::vector<BiMap> &GetEnumDictionaries() const { return enum_dicts_; }
+
   /**
    * Get number of unwanted tuples
    */
@@ -89,11 +96,13 @@ class RelationDecompressor {
 
   std::vector<std::unique_ptr<SquIDModel> > model_;
   std::vector<size_t> attr_order_;
+  std::vector<BiMap> enum_dicts_;
   Decoder decoder_;
 
   // bit buffer: it is used to store (used but not necessary) bits
   std::vector<bool> bit_buffer_;
   int bit_buffer_index_;
+  BitString code_word_;
 
   int data_pos_;
   uint32_t num_bytes_;
@@ -119,6 +128,6 @@ class RelationDecompressor {
   void EmitAdditionBits(UnitProbInterval &PIb, const ProbInterval &PIt);
 };
 
-}  // namespace db_compress
+}  // namespace db_compress::arith
 
 #endif
@@ -2,28 +2,32 @@
  * The header file for tuple Index
  */
 
-#ifndef INDEX_H
-#define INDEX_H
+#ifndef ARITH_INDEX_H
+#define ARITH_INDEX_H
 
 #include <memory>
 
 #include "data_io.h"
 #include "squish_exception.h"
 
-namespace db_compress {
+namespace db_compress::arith {
 /**
  * Indexer creator of squish, the core component of random access. It is used to
  * create a indexer file when compression. Length of compressed bits for each
- * tuple is recorded in temp.index file, called index table. After compression,
- * we concatenate temp.index with compressed binary file.
+ * tuple is recorded in a temporary index file next to the compressed file,
+ * called index table. After compression, we concatenate the index file with
+ * compressed binary file.
  */
 class IndexCreator {
  public:
   /**
    * Create a index creator.
+   *
+   * @param output_file compressed file address, the index file is named after it
    */
-  IndexCreator()
-      : file_writer_(std::make_unique<SequenceByteWriter>(index_file_)),
+  explicit IndexCreator(const std::string &output_file)
+      : index_file_(output_file + ".index"),
+        file_writer_(std::make_unique<SequenceByteWriter>(index_file_)),
         num_tuple_in_last_block_(0),
         num_block_(0) {}
 
@@ -66,7 +70,7 @@ class IndexCreator {
   }
 
  private:
-  const std::string index_file_ = "temp.index";
+  const std::string index_file_;
   std::unique_ptr<SequenceByteWriter> file_writer_;
   int num_block_;
   unsigned num_tuple_in_last_block_;
@@ -140,6 +144,6 @@ class IndexReader {
   int mid_;
 };
 
-}  // namespace db_compress
+}  // namespace db_compress::arith
 
-#endif  // !INDEX_H
+#endif  // !ARITH_INDEX_H
@@ -2,8 +2,8 @@
  * This header file defines SquID interface and several related classes.
  */
 
-#ifndef MODEL_H
-#define MODEL_H
+#ifndef ARITH_MODEL_H
+#define ARITH_MODEL_H
 
 #include <functional>
 #include <unordered_map>
@@ -13,7 +13,7 @@
 #include "data_io.h"
 #include "utility.h"
 
-namespace db_compress {
+namespace db_compress::arith {
 class Decoder;
 
 /**
@@ -258,6 +258,6 @@ const AttrInterpreter *GetAttrInterpreter(int attr_type);
 
 std::vector<size_t> GetPredictorCap(const std::vector<size_t> &pred);
 
-}  // namespace db_compress
+}  // namespace db_compress::arith
 
 #endif
@@ -1,5 +1,5 @@
-#ifndef MODEL_LEARNER_H
-#define MODEL_LEARNER_H
+#ifndef ARITH_MODEL_LEARNER_H
+#define ARITH_MODEL_LEARNER_H
 
 #include <map>
 #include <memory>
@@ -10,7 +10,7 @@
 #include "data_io.h"
 #include "model.h"
 
-namespace db_compress {
+namespace db_compress::arith {
 
 /**
  * Compression config. Squish could skip model learning stage, and utilize given
@@ -107,6 +107,6 @@ class ModelLearner {
   int GetModelCost(const std::vector<size_t> &predictor, size_t target) const;
 };
 
-}  // namespace db_compress
+}  // namespace db_compress::arith
 
 #endif
@@ -1,7 +1,7 @@
 // The numerical SquID and SquIDModel header
 
-#ifndef NUMERICAL_MODEL_H
-#define NUMERICAL_MODEL_H
+#ifndef ARITH_NUMERICAL_MODEL_H
+#define ARITH_NUMERICAL_MODEL_H
 
 #include <vector>
 
@@ -9,7 +9,7 @@
 #include "model.h"
 #include "utility.h"
 
-namespace db_compress {
+namespace db_compress::arith {
 
 const int kNumBranch1stLayer = 256;
 const int kNumSigma = 6;
@@ -233,6 +233,6 @@ class TableNumericalIntCreator : public ModelCreator {
   const size_t kMaxTableSize = 1000;
 };
 
-}  // namespace db_compress
+}  // namespace db_compress::arith
 
 #endif
@@ -2,12 +2,12 @@
 // Created by Qiao Yiming on 2022/3/3.
 //
 
-#ifndef DB_COMPRESS_SQUISH_EXCEPTION_H
-#define DB_COMPRESS_SQUISH_EXCEPTION_H
+#ifndef ARITH_SQUISH_EXCEPTION_H
+#define ARITH_SQUISH_EXCEPTION_H
 #include <exception>
 #include <iostream>
 
-namespace db_compress {
+namespace db_compress::arith {
 class BufferOverflowException : public std::exception {
  public:
   BufferOverflowException(std::string msg) : msg_(msg) {}
@@ -27,6 +27,6 @@ class IOException : public std::exception {
  private:
   std::string msg_;
 };
-}  // namespace db_compress
+}  // namespace db_compress::arith
 
-#endif  // DB_COMPRESS_SQUISH_EXCEPTION_H
+#endif  // ARITH_SQUISH_EXCEPTION_H
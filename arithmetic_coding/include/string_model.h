@@ -1,12 +1,12 @@
-#ifndef STRING_MODEL_H
-#define STRING_MODEL_H
+#ifndef ARITH_STRING_MODEL_H
+#define ARITH_STRING_MODEL_H
 
 #include <vector>
 
 #include "base.h"
 #include "model.h"
 
-namespace db_compress {
+namespace db_compress::arith {
 
 class StringSquID : public SquID {
  public:
@@ -69,6 +69,6 @@ class StringModelCreator : public ModelCreator {
   SquIDModel *CreateModel(const std::vector<int> &attr_type, const std::vector<size_t> &predictor, size_t index,
                           double err);
 };
-}  // namespace db_compress
+}  // namespace db_compress::arith
 
 #endif
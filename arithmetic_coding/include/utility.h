@@ -1,14 +1,15 @@
 // This header defines many utility functions
 
-#ifndef UTILITY_H
-#define UTILITY_H
+#ifndef ARITH_UTILITY_H
+#define ARITH_UTILITY_H
 
 #include <cmath>
 #include <vector>
 
 #include "base.h"
+#include "data_io.h"
 
-namespace db_compress {
+namespace db_compress::arith {
 
 /**
  * Dynamic List behaves like multi-dimensional array, except that the number of
@@ -265,6 +266,22 @@ void Write(const std::vector<BiMap> &data);
 
 // This reads a vector of non-trivial data types.
 void Read(std::vector<BiMap> &data);
-}  // namespace db_compress
+
+/**
+ * Write enum dictionaries into a compressed file.
+ *
+ * @param data enum values of each attribute
+ * @param byte_writer byte writer
+ */
+void WriteEnumDictionaries(const std::vector<BiMap> &data, SequenceByteWriter *byte_writer);
+
+/**
+ * Read enum dictionaries written by WriteEnumDictionaries().
+ *
+ * @param byte_reader byte reader
+ * @param[out] data enum values of each attribute
+ */
+void ReadEnumDictionaries(ByteReader *byte_reader, std::vector<BiMap> *data);
+}  // namespace db_compress::arith
 
 #endif
@@ -0,0 +1,168 @@
+#include "../include/arithmetic_codec.h"
+
+#include <blitzcrank_exception.h>
+#include <model.h>
+
+#include <memory>
+#include <string>
+
+#include "../include/base.h"
+#include "../include/categorical_model.h"
+#include "../include/compression.h"
+#include "../include/decompression.h"
+#include "../include/model.h"
+#include "../include/numerical_model.h"
+#include "../include/string_model.h"
+
+namespace db_compress::arith {
+namespace {
+/**
+ * It interprets attributes with the interpreter registered in db_compress for the same attribute.
+ */
+class BridgeInterpreter : public AttrInterpreter {
+ public:
+  explicit BridgeInterpreter(int attr_index) : attr_index_(attr_index) {}
+
+  bool EnumInterpretable() const override { return Get()->EnumInterpretable(); }
+  int EnumCap() const override { return Get()->EnumCap(); }
+  size_t EnumInterpret(const AttrValue &attr) const override {
+    return Get()->EnumInterpret(::db_compress::AttrValue(attr.Int()));
+  }
+
+ private:
+  int attr_index_;
+
+  const ::db_compress::AttrInterpreter *Get() const {
+    return ::db_compress::GetAttrInterpreter(attr_index_);
+  }
+};
+
+// Register models of the supported attribute types and an interpreter per attribute.
+void RegisterModels(const Schema &schema) {
+  for (size_t i = 0; i < schema.size(); ++i) {
+    if (schema.attr_type_[i] < 0 || schema.attr_type_[i] > 3)
+      throw ::db_compress::BlitzcrankException(
+          "Arithmetic coding cannot encode attribute " + std::to_string(i) + " of type " +
+          std::to_string(schema.attr_type_[i]) + ".\n");
+  }
+  RegisterAttrModel(0, new TableCategoricalCreator());
+  RegisterAttrModel(1, new TableNumericalIntCreator());
+  RegisterAttrModel(2, new TableNumericalRealCreator());
+  RegisterAttrModel(3, new StringModelCreator());
+  for (size_t i = 0; i < schema.size(); ++i)
+    RegisterAttrInterpreter(static_cast<int>(i), new BridgeInterpreter(static_cast<int>(i)));
+}
+
+CompressionConfig GetConfig(const ::db_compress::CompressionConfig &config) {
+  CompressionConfig ret;
+  ret.allowed_err_ = config.allowed_err_;
+  ret.sort_by_attr_ = -1;
+  ret.skip_model_learning_ = config.skip_model_learning_;
+  return ret;
+}
+
+// Both tuple types hold the same variant.
+inline void Convert(const ::db_compress::AttrVector &from, AttrVector *to) {
+  for (size_t i = 0; i < from.attr_.size(); ++i) to->attr_[i].value_ = from.attr_[i].value_;
+}
+
+inline void Convert(const AttrVector &from, ::db_compress::AttrVector *to) {
+  to->attr_.resize(from.attr_.size());
+  for (size_t i = 0; i < from.attr_.size(); ++i) to->attr_[i].value_ = from.attr_[i].value_;
+}
+
+template <class FromBiMap, class ToBiMap>
+std::vector<ToBiMap> Convert(const std::vector<FromBiMap> &from) {
+  std::vector<ToBiMap> to(from.size());
+  for (size_t i = 0; i < from.size(); ++i) {
+    to[i].enums = from[i].enums;
+    to[i].enum2idx = from[i].enum2idx;
+  }
+  return to;
+}
+}  // anonymous namespace
+
+bool IsSupportedSchema(const ::db_compress::Schema &schema) {
+  for (int attr_type : schema.attr_type_)
+    if (attr_type < 0 || attr_type > 3) return false;
+  return true;
+}
+
+ArithmeticCompressor::ArithmeticCompressor(const char *output_file,
+                                           const ::db_compress::Schema &schema,
+                                           const ::db_compress::CompressionConfig &config,
+                                           int block_size) {
+  Schema arith_schema(schema.attr_type_);
+  RegisterModels(arith_schema);
+  compressor_ = std::make_unique<RelationCompressor>(output_file, arith_schema, GetConfig(config),
+                                                     block_size);
+  tuple_ = std::make_unique<AttrVector>(static_cast<int>(schema.size()));
+}
+
+ArithmeticCompressor::~ArithmeticCompressor() = default;
+
+bool ArithmeticCompressor::RequireFullPass() const { return compressor_->RequireFullPass(); }
+
+bool ArithmeticCompressor::RequireMoreIterationsForLearning() const {
+  return compressor_->RequireMoreIterationsForLearning();
+}
+
+void ArithmeticCompressor::LearnTuple(const ::db_compress::AttrVector &tuple) {
+  Convert(tuple, tuple_.get());
+  compressor_->LearnTuple(*tuple_);
+}
+
+void ArithmeticCompressor::CompressTuple(::db_compress::AttrVector &tuple) {
+  Convert(tuple, tuple_.get());
+  compressor_->CompressTuple(*tuple_);
+}
+
+void ArithmeticCompressor::SetEnumDictionaries(const std::vector<::db_compress::BiMap> &dicts) {
+  compressor_->SetEnumDictionaries(Convert<::db_compress::BiMap, BiMap>(dicts));
+}
+
+void ArithmeticCompressor::EndOfLearning() { compressor_->EndOfLearning(); }
+
+void ArithmeticCompressor::EndOfCompress() { compressor_->EndOfCompress(); }
+
+ArithmeticDecompressor::ArithmeticDecompressor(const char *compressed_file_name,
+                                               const ::db_compress::Schema &schema,
+                                               int block_size)
+    : num_attrs_(schema.size()) {
+  Schema arith_schema(schema.attr_type_);
+  RegisterModels(arith_schema);
+  decompressor_ =
+      std::make_unique<RelationDecompressor>(compressed_file_name, arith_schema, block_size);
+  tuple_ = std::make_unique<AttrVector>(static_cast<int>(num_attrs_));
+}
+
+ArithmeticDecompressor::~ArithmeticDecompressor() = default;
+
+void ArithmeticDecompressor::Init() {
+  decompressor_->Init();
+  enum_dicts_ = Convert<BiMap, ::db_compress::BiMap>(decompressor_->GetEnumDictionaries());
+}
+
+int ArithmeticDecompressor::GetNumTotalTuples() const { return decompressor_->num_total_tuples_; }
+
+void ArithmeticDecompressor::LocateTuple(uint32_t tuple_idx) {
+  decompressor_->LocateTuple(static_cast<int>(tuple_idx));
+}
+
+void ArithmeticDecompressor::ReadNextTuple(::db_compress::AttrVector *tuple) {
+  decompressor_->ReadNextTuple(tuple_.get());
+  Convert(*tuple_, tuple);
+}
+
+bool ArithmeticDecompressor::HasNext() const { return decompressor_->HasNext(); }
+
+void ArithmeticDecompressor::ParallelScan(
+    int /*num_threads*/,
+    const std::function<void(int, size_t, const ::db_compress::AttrVector &)> &callback) {
+  ::db_compress::AttrVector tuple(static_cast<int>(num_attrs_));
+  for (size_t tuple_idx = 0; HasNext(); ++tuple_idx) {
+    ReadNextTuple(&tuple);
+    callback(0, tuple_idx, tuple);
+  }
+}
+}  // namespace db_compress::arith
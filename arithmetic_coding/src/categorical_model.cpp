@@ -7,7 +7,7 @@
 #include "../include/model.h"
 #include "../include/utility.h"
 
-namespace db_compress {
+namespace db_compress::arith {
 
 void CategoricalSquID::Decompress(Decoder *decoder, ByteReader *byte_reader) {
   branch_left_ = 0;
@@ -195,4 +195,4 @@ SquIDModel *TableCategoricalCreator::CreateModel(const std::vector<int> &attr_ty
   return new TableCategorical(attr_type, predictors, index, err);
 }
 
-}  // namespace db_compress
+}  // namespace db_compress::arith
@@ -11,7 +11,7 @@
 #include "../include/string_model.h"
 #include "../include/utility.h"
 
-namespace db_compress {
+namespace db_compress::arith {
 /**
  * Write bit_string_ with byte_writer.
  */
@@ -35,6 +35,7 @@ void WriteBitString(SequenceByteWriter *byte_writer, const BitString &bit_string
 RelationCompressor::RelationCompressor(const char *outputFile, const Schema &schema,
                                        const CompressionConfig &config, int block_size)
     : output_file_(outputFile),
+      index_creator_(outputFile),
       kBlockSizeThreshold_(block_size),
       schema_(schema),
       learner_(new ModelLearner(schema, config)),
@@ -134,6 +135,11 @@ void RelationCompressor::EndOfLearning() {
 
     // Initialize Compressed File
     byte_writer_ = std::make_unique<SequenceByteWriter>(output_file_);
+    // Container header, see ReadCodecId() of db_compress
+    byte_writer_->Write16Bit(kContainerMagic >> 16);
+    byte_writer_->Write16Bit(kContainerMagic & 0xFFFF);
+    byte_writer_->Write16Bit(kContainerVersion);
+    byte_writer_->Write16Bit(kArithmeticCodingBackend);
     // Write Models
     // Randomly sampled tuples should not be counted.
     byte_writer_->WriteUnsigned(num_tuples_ - kNumEstSample);
@@ -142,6 +148,7 @@ void RelationCompressor::EndOfLearning() {
     for (size_t i = 0; i < schema_.attr_type_.size(); ++i) {
       model_[i]->WriteModel(byte_writer_.get());
     }
+    WriteEnumDictionaries(enum_dicts_, byte_writer_.get());
   }
   // Reset the number of tuples, compute it again in the new
   // round.
@@ -157,4 +164,4 @@ void RelationCompressor::EndOfCompress() {
   index_creator_.End(output_file_);
 }
 
-}  // namespace db_compress
+}  // namespace db_compress::arith
@@ -7,7 +7,7 @@
 #include "../include/base.h"
 #include "../include/squish_exception.h"
 
-namespace db_compress {
+namespace db_compress::arith {
 
 SequenceByteWriter::SequenceByteWriter(const std::string &file_name)
     : file_(file_name, std::ios::binary), buffer_{0}, bits_counter_(0) {
@@ -105,4 +105,4 @@ void ByteReader::Read32Bit(unsigned char *bytes) {
   }
 }
 
-}  // namespace db_compress
+}  // namespace db_compress::arith
@@ -6,9 +6,11 @@
 #include "../include/base.h"
 #include "../include/categorical_model.h"
 #include "../include/numerical_model.h"
+#include "../include/squish_exception.h"
 #include "../include/string_model.h"
+#include "../include/utility.h"
 
-namespace db_compress {
+namespace db_compress::arith {
 
 namespace {
 
@@ -27,6 +29,17 @@ RelationDecompressor::RelationDecompressor(const char *compressedFileName,
       num_converted_tuples_(0), bit_buffer_(64), bit_buffer_index_(0) {}
 
 void RelationDecompressor::Init() {
+  // Container header
+  unsigned magic = byte_reader_.Read16Bit() << 16;
+  magic |= byte_reader_.Read16Bit();
+  unsigned version = byte_reader_.Read16Bit();
+  if (magic != kContainerMagic || version != kContainerVersion)
+    throw IOException("RelationDecompressor::Init::Unsupported container. Version: " +
+                      std::to_string(version) + "\n");
+  unsigned codec_id = byte_reader_.Read16Bit();
+  if (codec_id != kArithmeticCodingBackend)
+    throw IOException("RelationDecompressor::Init::Not an arithmetic coding file. Codec: " +
+                      std::to_string(codec_id) + "\n");
   // Number of tuples
   num_total_tuples_ = byte_reader_.Read32Bit();
   // Ordering of attributes
@@ -40,6 +53,7 @@ void RelationDecompressor::Init() {
         GetModelFromDescription(&byte_reader_, schema_, i));
     model_[i] = std::move(model);
   }
+  ReadEnumDictionaries(&byte_reader_, &enum_dicts_);
 
   // Default: decompress the whole data set
   num_unwanted_tuples_ = 0;
@@ -66,7 +80,7 @@ void RelationDecompressor::LocateTuple(int tuple_idx) {
   num_wanted_tuples_ = 1;
   num_todo_tuples_ = num_unwanted_tuples_ + num_wanted_tuples_;
   num_converted_tuples_ = 0;
-  decoder_.InitProbInterval();
+  bit_buffer_index_ = 0;
 }
 
 void RelationDecompressor::ReadNextTuple(AttrVector *tuple) {
@@ -78,7 +92,7 @@ void RelationDecompressor::ReadNextTuple(AttrVector *tuple) {
       auto model = static_cast<TableCategorical *>(model_[attr_index].get());
       CategoricalSquID *squid = model->GetSquID(*tuple);
       squid->Decompress(&decoder_, &byte_reader_);
-      // tuple->attr_[attr_index] = squid->GetResultAttr();
+      tuple->attr_[attr_index] = squid->GetResultAttr();
       break;
     }
     case 1: {
@@ -112,11 +126,11 @@ void RelationDecompressor::ReadNextTuple(AttrVector *tuple) {
   //  }
 }
 void RelationDecompressor::InitPIb(UnitProbInterval &PIb) {
-//  decoder_.InitProbInterval();
-//  for (int i = bit_buffer_index_ - 1; i >= 0; --i)
-//    PIb.Go(bit_buffer_[i]);
-
-//  bit_buffer_index_ = 0;
+  // Every tuple is coded independently, it starts with the bits read ahead by the last tuple.
+  decoder_.InitProbInterval();
+  for (int i = bit_buffer_index_ - 1; i >= 0; --i)
+    PIb.Go(bit_buffer_[i]);
+  bit_buffer_index_ = 0;
 
   while (PIb.exp_ < 32) {
     PIb.GoByte(byte_reader_.ReadByte());
@@ -127,11 +141,11 @@ void RelationDecompressor::InitPIb(UnitProbInterval &PIb) {
 }
 void RelationDecompressor::EmitAdditionBits(UnitProbInterval &PIb,
                                             const ProbInterval &PIt) {
-//  while (PIb.IncludedBy(PIt))
-//    bit_buffer_[bit_buffer_index_++] = PIb.Back();
-//
-//  // the last bit should be taken, since PIb needs it to be included by PIt
-//  --bit_buffer_index_;
+  // The tuple ends with the shortest bit string whose probability interval is
+  // included by PIt, the rest of PIb belongs to the next tuple.
+  GetBitStringFromProbInterval(&code_word_, PIt);
+  while (PIb.exp_ > static_cast<int>(code_word_.length_))
+    bit_buffer_[bit_buffer_index_++] = PIb.Back();
 }
 
-} // namespace db_compress
+}  // namespace db_compress::arith
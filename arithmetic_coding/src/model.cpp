@@ -6,7 +6,7 @@
 
 #include "../include/base.h"
 
-namespace db_compress {
+namespace db_compress::arith {
 
 namespace {
 std::map<int, std::unique_ptr<ModelCreator> > model_rep;
@@ -61,4 +61,4 @@ SquIDModel::SquIDModel(const std::vector<size_t> &predictors, size_t target_var)
     : predictor_list_(predictors),
       predictor_list_size_(predictors.size()),
       target_var_(target_var) {}
-}  // namespace db_compress
+}  // namespace db_compress::arith
@@ -9,7 +9,7 @@
 #include "../include/base.h"
 #include "../include/model.h"
 
-namespace db_compress {
+namespace db_compress::arith {
 
 namespace {
 
@@ -186,4 +186,4 @@ void ModelLearner::InitActiveModelList() {
   }
 }
 
-}  // namespace db_compress
+}  // namespace db_compress::arith
@@ -9,7 +9,7 @@
 #include "../include/squish_exception.h"
 #include "../include/utility.h"
 
-namespace db_compress {
+namespace db_compress::arith {
 
 namespace {
 const double kEulerConstant = std::exp(1.0);
@@ -294,7 +294,7 @@ void NumericalSquID::HistogramDecompress(Decoder *decoder, ByteReader *byte_read
     for (int i = num_layer_; i > 0; --i) {
       while (decoder->GetPIb().exp_ < 40) decoder->FeedByte(byte_reader->ReadByte());
       branch = decoder->GetPIbPItRatio();
-      decoder->UpdatePIt({branch, branch + 1});
+      decoder->UpdatePIt({static_cast<Prob>(branch), static_cast<Prob>(branch + 1)});
       // Second layer, histogram part, branch represents the number of bins away
       // from the left boundary. WARNING: l_ changes after calling SetLeft(),
       // thus it is necessary to record l_ at first.
@@ -309,7 +309,8 @@ void NumericalSquID::HistogramDecompress(Decoder *decoder, ByteReader *byte_read
   prob_pit_pib_ratio_ = decoder->GetPIbPItRatio();
   branch = prob_pit_pib_ratio_ / weight_branch_last_layer_;
   decoder->UpdatePIt(
-      {branch * weight_branch_last_layer_, (branch + 1) * weight_branch_last_layer_});
+      {static_cast<Prob>(branch * weight_branch_last_layer_),
+       static_cast<Prob>((branch + 1) * weight_branch_last_layer_)});
   const int64_t l_record = l_;
   SetLeft(l_record + branch);
   SetRight(l_record + branch);
@@ -550,4 +551,4 @@ SquIDModel *TableNumericalIntCreator::CreateModel(const std::vector<int> &attr_t
   }
   return new TableNumerical(attr_type, predictors, index, err, true);
 }
-}  // namespace db_compress
+}  // namespace db_compress::arith
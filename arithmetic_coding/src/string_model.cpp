@@ -7,7 +7,7 @@
 #include "../include/model.h"
 #include "../include/utility.h"
 
-namespace db_compress {
+namespace db_compress::arith {
 
 inline void StringSquID::Init(const std::vector<Prob> *char_prob,
                               const std::vector<Prob> *len_prob) {
@@ -36,15 +36,12 @@ void StringSquID::ChooseNextBranch(int branch) {
 }
 
 ProbInterval &StringSquID::GenerateNextBranch(int branch) {
-  std::vector<Prob> prob_segs_;
-  if (word_length_ == -1)
-    prob_segs_ = *len_prob_;
-  else if (attr_.String().length() == 0)
-    prob_segs_ = *char_prob_;
+  // the length comes first, then every character shares the same distribution
+  const std::vector<Prob> &prob_segs = word_length_ == -1 ? *len_prob_ : *char_prob_;
 
   Prob l = GetZeroProb(), r = GetOneProb();
-  if (branch > 0) l = prob_segs_[branch - 1];
-  if (branch < (int)prob_segs_.size()) r = prob_segs_[branch];
+  if (branch > 0) l = prob_segs[branch - 1];
+  if (branch < (int)prob_segs.size()) r = prob_segs[branch];
   prob_interval_.left_prob_ = l;
   prob_interval_.right_prob_ = r;
 
@@ -52,14 +49,10 @@ ProbInterval &StringSquID::GenerateNextBranch(int branch) {
 }
 
 int StringSquID::GenerateNextBranchDecoder(int branch) {
-  std::vector<Prob> prob_segs_;
-  if (word_length_ == -1)
-    prob_segs_ = *len_prob_;
-  else if (attr_.String().length() == 0)
-    prob_segs_ = *char_prob_;
+  const std::vector<Prob> &prob_segs = word_length_ == -1 ? *len_prob_ : *char_prob_;
 
-  Prob l = GetZeroProb(), r = GetOneProb();
-  if (branch < (int)prob_segs_.size()) r = prob_segs_[branch];
+  Prob r = GetOneProb();
+  if (branch < (int)prob_segs.size()) r = prob_segs[branch];
 
   return r;
 }
@@ -160,4 +153,4 @@ SquIDModel *StringModelCreator::CreateModel(const std::vector<int> &attr_type,
   if (predictor.size() > 0) return NULL;
   return new StringModel(index);
 }
-}  // namespace db_compress
+}  // namespace db_compress::arith
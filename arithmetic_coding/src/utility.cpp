@@ -7,7 +7,7 @@
 
 #include "../include/base.h"
 
-namespace db_compress {
+namespace db_compress::arith {
 
 /*
  * The quantization follows two steps:
@@ -94,8 +94,10 @@ ProbInterval ReducePIProduct(const std::vector<ProbInterval> &vec,
   if (vec_size == 0) {
     return {GetZeroProb(), GetOneProb()};
   }
-  ProbInterval ret = vec[0];
-  for (size_t i = 1; i < vec_size; ++i) {
+  // Start from [0, 1] like the decoder does, so that a first interval of length 1 emits the same
+  // bytes on both sides.
+  ProbInterval ret(GetZeroProb(), GetOneProb());
+  for (size_t i = 0; i < vec_size; ++i) {
     GetPIProduct(ret, vec[i], emit_bytes, emit_byte_index);
   }
   return ret;
@@ -245,4 +247,29 @@ void Read(std::vector<BiMap> &data) {
     }
   }
 }
-}  // namespace db_compress
+
+void WriteEnumDictionaries(const std::vector<BiMap> &data, SequenceByteWriter *byte_writer) {
+  byte_writer->WriteUnsigned(data.size());
+  for (const BiMap &map : data) {
+    byte_writer->WriteUnsigned(map.enums.size());
+    for (const std::string &s : map.enums) {
+      byte_writer->WriteUnsigned(s.size());
+      for (char c : s) byte_writer->WriteByte(c);
+    }
+  }
+}
+
+void ReadEnumDictionaries(ByteReader *byte_reader, std::vector<BiMap> *data) {
+  data->assign(static_cast<unsigned>(byte_reader->Read32Bit()), BiMap());
+  for (BiMap &map : *data) {
+    unsigned num_enums = byte_reader->Read32Bit();
+    map.enums.resize(num_enums);
+    for (unsigned i = 0; i < num_enums; ++i) {
+      std::string &s = map.enums[i];
+      s.resize(static_cast<unsigned>(byte_reader->Read32Bit()));
+      for (char &c : s) c = static_cast<char>(byte_reader->ReadByte());
+      map.enum2idx[s] = static_cast<int>(i);
+    }
+  }
+}
+}  // namespace db_compress::arith
@@ -6,7 +6,9 @@
 #ifndef BASE_H
 #define BASE_H
 
+#include <algorithm>
 #include <cassert>
+#include <cstdint>
 #include <iostream>
 #include <map>
 #include <string>
@@ -24,10 +26,59 @@ namespace db_compress {
 #define kIntervalSize 10000
 
 // Delayed Coding. For random access, we recommend 16; for best compression ratio, we recommend 24.
+// It is the default precision, the precision of a relational file is recorded in its header and
+// can be any value in [kMinDelayedCoding, kMaxDelayedCoding].
 #define kDelayedCoding 24
+#define kMinDelayedCoding 16
+#define kMaxDelayedCoding 48
 #define kBlockSize 1
+// Maximum number of interleaved delayed coding states, it must be a power of two.
+#define kMaxInterleavedStates 8
+// Number of bits shifted out by one renormalization of the default engine, 16 or 32.
+#define kRenormBits 16
 
-// String Model
+// Container. A compressed file starts with kContainerMagic (32 bits), kContainerVersion (16 bits)
+// and the backend (16 bits). A relational file ends with a footer of kContainerFooterSize bytes,
+// i.e. byte offsets of its model, data, enum and index sections, of the optional index image and
+// of the optional checkpoint section (0 if there is none), followed by kContainerMagic.
+// Cross-tuple model state, i.e. markov state and local dictionaries, is reset at every block start.
+#define kContainerMagic 0x424C5A43
+#define kContainerVersion 6
+#define kContainerFooterSize 52
+// Entropy coding backends of relational files, the backend of a file is recorded right after the
+// container version. Arithmetic coding files are written by the db_compress_arith library.
+#define kDelayedCodingBackend 0
+#define kRansBackend 1
+#define kArithmeticCodingBackend 2
+// rANS. Every interleaved state lies in [kRansLowerBound, 2^64), it is renormalized by 32 bits.
+#define kRansLowerBound (static_cast<uint64_t>(1) << 32)
+
+// IO. Zero bytes following a memory mapped file, readers may look this many bytes past the end.
+#define kMappedFilePadding 16
+// IO. A scan worker drops pages of blocks it has decoded once they are this many bytes behind it,
+// so that scanning a file larger than memory keeps a bounded resident set.
+#define kScanResidentBytes (64 << 20)
+// IO. Sequential scans request block data ahead of decoding, about kReadAheadMicros of decoding at
+// the measured rate, within [kReadAheadMinBytes, kReadAheadMaxBytes].
+#define kReadAheadMicros 20000
+#define kReadAheadMinBytes (1 << 20)
+#define kReadAheadMaxBytes (256 << 20)
+// IO. Output buffer of SequenceByteWriter in bytes.
+#define kWriterBufferSize (1 << 20)
+// Random Access. A batch of lookups keeps kLookupGroupSize index searches in flight, then requests
+// the index entries, the checkpoint and the first kLookupPrefetchLines cache lines of block data of
+// a lookup 3, 2 and 1 times kLookupGroupSize blocks ahead of decoding, so that the cache misses of
+// different lookups overlap.
+#define kLookupGroupSize 16
+#define kLookupPrefetchLines 4
+
+// Categorical Model. The flat decode table of a categorical statistic is indexed by the top
+// (num_represent_bits + kDecodeTableExtraBits) bits of a word, but at most kDecodeTableMaxBits.
+#define kDecodeTableExtraBits 3
+#define kDecodeTableMaxBits 12
+
+// String Model. It is the default local dictionary size, the size used by a string model is
+// recorded in its model description.
 #define kLocalDictSize 1
 #define kMarkovModel 1
 
@@ -108,17 +159,125 @@ struct ProbInterval {
 struct Branch {
   std::vector<ProbInterval> segments_; /**< each branch has several segments_ */
   unsigned total_weights_;             /**< weights of each branch*/
+  uint64_t reciprocal_{0};             /**< floor((2^64 - 1) / total_weights_) */
+  std::vector<Prob> segment_prefix_;   /**< sum of lengths of former segments_ */
 
   Branch() = default;
 
   Branch(std::vector<ProbInterval> segments, unsigned total_weights)
-      : segments_(std::move(segments)), total_weights_(total_weights) {}
+      : segments_(std::move(segments)), total_weights_(total_weights) {
+    Prepare();
+  }
 
   Branch(unsigned total_weight, ProbInterval PI) : total_weights_(total_weight) {
     segments_.push_back(PI);
+    Prepare();
+  }
+
+  /**
+   * Precompute the reciprocal of total weight and the segment prefix table for
+   * delayed coding. It must be called again once segments_ or total_weights_
+   * change. The prefix table is only needed by branches with several segments_.
+   */
+  void Prepare() {
+    reciprocal_ = total_weights_ == 0 ? 0 : UINT64_MAX / total_weights_;
+    segment_prefix_.clear();
+    if (segments_.size() <= 1) return;
+    Prob prefix = 0;
+    for (const ProbInterval &segment : segments_) {
+      segment_prefix_.push_back(prefix);
+      prefix += segment.right_prob_ - segment.left_prob_;
+    }
+  }
+
+  /**
+   * Compute quotient and remainder of val / total_weights_ with the reciprocal.
+   * The estimated quotient is at most one less than the real one, so a single
+   * correction step is enough.
+   *
+   * @param val dividend
+   * @param[out] rem val % total_weights_
+   * @return val / total_weights_
+   */
+  inline uint64_t DivMod(uint64_t val, uint64_t *rem) const {
+    auto quotient =
+        static_cast<uint64_t>((static_cast<unsigned __int128>(val) * reciprocal_) >> 64);
+    uint64_t remainder = val - quotient * total_weights_;
+    if (remainder >= total_weights_) {
+      ++quotient;
+      remainder -= total_weights_;
+    }
+    *rem = remainder;
+    return quotient;
+  }
+
+  /**
+   * Given a numerator, find the right position in [0, 65535] to encode two
+   * information: 1) branch; 2) numerator.
+   *
+   * @param num numerator, less than total_weights_
+   * @return embedded 16 bits
+   */
+  inline uint16_t Embed(uint64_t num) const {
+    if (segment_prefix_.empty()) return segments_[0].left_prob_ + num;
+    size_t k = std::upper_bound(segment_prefix_.begin() + 1, segment_prefix_.end(),
+                                static_cast<Prob>(num)) -
+               segment_prefix_.begin() - 1;
+    return segments_[k].left_prob_ + (num - segment_prefix_[k]);
   }
 };
 
+/**
+ * Delayed coding engine, shared by encoder and decoder. It is recorded in the
+ * header of a compressed file.
+ */
+struct DelayedCodingConfig {
+  // Either kDelayedCodingBackend or kRansBackend. Both backends consume the same branches, the
+  // rANS backend only uses num_states_.
+  int backend_{kDelayedCodingBackend};
+  // Probability intervals are spread round-robin across interleaved states, a power of two no
+  // larger than kMaxInterleavedStates.
+  int num_states_{1};
+  // Once denominator reaches 2^precision, the state is renormalized.
+  int precision_{kDelayedCoding};
+  // Bits shifted out by one renormalization, they become 16-bit virtual words of the following
+  // probability intervals. Either 16 or 32, and no larger than precision.
+  int renorm_bits_{kRenormBits};
+  // Append the index image, i.e. lookup tables of blocks that are used in place when a file is
+  // opened. It costs 12 to 20 bytes per block.
+  bool index_image_{false};
+  // Record a checkpoint of the delayed coding decoder every checkpoint_tuples_ tuples of a block,
+  // so that random access resumes from the nearest one instead of the block start. 0 for none,
+  // rANS files have none.
+  int checkpoint_tuples_{0};
+
+  bool IsValid() const {
+    return (backend_ == kDelayedCodingBackend || backend_ == kRansBackend) &&
+           checkpoint_tuples_ >= 0 && (checkpoint_tuples_ == 0 || backend_ != kRansBackend) &&
+           num_states_ > 0 &&
+           num_states_ <= kMaxInterleavedStates &&
+           (num_states_ & (num_states_ - 1)) == 0 && (renorm_bits_ == 16 || renorm_bits_ == 32) &&
+           precision_ >= std::max(kMinDelayedCoding, renorm_bits_) &&
+           precision_ <= kMaxDelayedCoding;
+  }
+};
+
+/**
+ * The state of the delayed coding decoder right before a probability interval of a block, see
+ * DelayedCoding(). Decoding may resume there instead of at the block start.
+ */
+struct DecoderCheckpoint {
+  // index of the probability interval in block
+  uint32_t interval_;
+  // 16-bit words of block read before the probability interval
+  uint32_t num_words_;
+  // per interleaved state
+  uint64_t num_[kMaxInterleavedStates];
+  uint64_t den_[kMaxInterleavedStates];
+  uint32_t virtual_bits_[kMaxInterleavedStates];
+  uint16_t num_virtual_[kMaxInterleavedStates];
+};
+
 /**
  * To apply delayed coding, these params are needed.
  */
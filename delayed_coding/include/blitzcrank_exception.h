@@ -19,6 +19,16 @@ class BufferOverflowException : public std::exception {
   std::string msg_;
 };
 
+class BlitzcrankException : public std::exception {
+ public:
+  explicit BlitzcrankException(std::string msg) : msg_(msg) {}
+
+  const char *what() const noexcept override { return msg_.c_str(); }
+
+ private:
+  std::string msg_;
+};
+
 class IOException : public std::exception {
  public:
   explicit IOException(std::string msg) : msg_(msg) {}
@@ -0,0 +1,98 @@
+/**
+ * @file block_cache.h
+ * @brief Header file for the cache of decoded blocks.
+ */
+
+#ifndef BLOCK_CACHE_H
+#define BLOCK_CACHE_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "base.h"
+
+namespace db_compress {
+
+/**
+ * Hit and miss counters of a block cache.
+ */
+struct BlockCacheStats {
+  uint64_t hits_{0};
+  uint64_t misses_{0};
+};
+
+/**
+ * BlockCache keeps decoded tuples of blocks, so that lookups into a hot block
+ * do not decode it again. An entry is keyed by the tuple where decoding starts,
+ * i.e. a block start or a checkpoint, and holds the tuples decoded from there
+ * up to the farthest lookup so far. Entries are bounded by a byte budget and
+ * evicted in CLOCK order: a hit marks an entry as referenced, and the hand
+ * spares a referenced entry once, so that blocks looked up only once leave
+ * before hot ones.
+ */
+class BlockCache {
+ public:
+  /**
+   * Create an empty block cache.
+   *
+   * @param capacity_bytes byte budget of decoded tuples
+   */
+  explicit BlockCache(size_t capacity_bytes) : capacity_bytes_(capacity_bytes) {}
+
+  /**
+   * Look up a tuple, it counts as a hit or a miss.
+   *
+   * @param start_tuple the tuple where decoding starts
+   * @param offset index of tuple from start_tuple
+   * @return the decoded tuple, or nullptr if it is not cached
+   */
+  const AttrVector *Find(uint32_t start_tuple, uint32_t offset);
+
+  /**
+   * Cache tuples decoded from a start tuple, they replace fewer tuples of the
+   * same start. Nothing is cached if they alone are beyond the byte budget.
+   *
+   * @param start_tuple the tuple where decoding starts
+   * @param tuples tuples decoded from start_tuple
+   */
+  void Insert(uint32_t start_tuple, std::vector<AttrVector> &&tuples);
+
+  /**
+   * @return hit and miss counters
+   */
+  const BlockCacheStats &Stats() const { return stats_; }
+
+  /**
+   * @return bytes of decoded tuples held by the cache
+   */
+  size_t SizeBytes() const { return size_bytes_; }
+
+ private:
+  struct Entry {
+    uint32_t start_tuple_;
+    bool referenced_;
+    size_t bytes_;
+    std::vector<AttrVector> tuples_;
+  };
+
+  size_t capacity_bytes_;
+  size_t size_bytes_{0};
+  // entries in clock order, the hand points at the next entry to be examined
+  std::vector<Entry> entries_;
+  size_t hand_{0};
+  // start tuple -> position in entries_
+  std::unordered_map<uint32_t, size_t> positions_;
+  BlockCacheStats stats_;
+
+  /**
+   * Evict entries until extra bytes fit in the byte budget.
+   *
+   * @param bytes bytes to be inserted
+   */
+  void MakeRoom(size_t bytes);
+};
+
+}  // namespace db_compress
+
+#endif  // BLOCK_CACHE_H
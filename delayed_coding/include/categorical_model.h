@@ -31,6 +31,21 @@ struct ZeroBranchHandler {
   void Init(std::vector<unsigned> weights);
 };
 
+/**
+ * One entry of the flat decode table. An entry covers all 16-bit words sharing
+ * the same top bits. If these words fall into the same segment, the branch,
+ * denominator and numerator offset of the segment are saved here; otherwise,
+ * the entry is split and decoding falls back to the segment tables.
+ */
+struct CategoricalDecodeEntry {
+  uint16_t branch_;
+  // denominator can be 65536, so denominator - 1 is saved
+  uint16_t denominator_minus_one_;
+  // numerator = 16 bits - numerator_offset_
+  uint16_t numerator_offset_;
+  uint16_t split_;
+};
+
 /**
  * Statistic of one specific categorical attribute, consists of a histogram and
  * delayed coding components.
@@ -49,6 +64,16 @@ struct CategoricalStats {
 
   // rare branch handle
   ZeroBranchHandler rare_branch_handler_;
+
+  // flat decode table, indexed by two_bytes >> decode_table_shift_
+  std::vector<CategoricalDecodeEntry> decode_table_;
+  int decode_table_shift_{16};
+
+  /**
+   * Build the flat decode table from delayed coding params, it should be called
+   * after InitDelayedCodingParams().
+   */
+  void InitDecodeTable();
 };
 
 /**
@@ -69,6 +94,8 @@ class CategoricalSquID {
     choice_ = -1;
     coding_params_ = &stats.coding_params_;
     rare_branch_handler_ = &stats.rare_branch_handler_;
+    decode_table_ = stats.decode_table_.empty() ? nullptr : stats.decode_table_.data();
+    decode_table_shift_ = stats.decode_table_shift_;
   }
 
   /**
@@ -101,11 +128,12 @@ class CategoricalSquID {
    * then it advances to the next layer of this decision tree. The result is
    * saved by class member variable choice_.
    *
-   * @param decoder it maintains the decompression process of delayed coding,
-   * some variables are saved here.
+   * @param decoder it maintains the decompression process of delayed coding
+   * or rANS, some variables are saved here.
    * @param byte_reader it reads bytes from compressed binary file
    */
-  void Decompress(Decoder *decoder, ByteReader *byte_reader);
+  template <class Engine>
+  void Decompress(Engine *decoder, ByteReader *byte_reader);
 
  private:
   // member variables
@@ -113,6 +141,8 @@ class CategoricalSquID {
   AttrValue attr_;
   DelayedCodingParams *coding_params_;
   ZeroBranchHandler *rare_branch_handler_;
+  const CategoricalDecodeEntry *decode_table_{nullptr};
+  int decode_table_shift_{16};
 };
 
 /**
@@ -18,7 +18,8 @@ class CategoricalTreeSquid {
   void GetProbIntervals(std::vector<Branch *> &prob_intervals, int &prob_intervals_index,
                         const AttrValue &value) const;
 
-  void Decompress(Decoder *decoder, ByteReader *byte_reader);
+  template <class Engine>
+  void Decompress(Engine *decoder, ByteReader *byte_reader);
 
   const AttrValue &GetResultAttr() { return attr_; }
 
@@ -0,0 +1,206 @@
+/**
+ * @file codec.h
+ * @brief The common interface of relational compressors and decompressors
+ */
+
+#ifndef CODEC_H
+#define CODEC_H
+
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <vector>
+
+#include "base.h"
+#include "block_cache.h"
+
+namespace db_compress {
+
+/**
+ * A tuple compressor, it is implemented by every codec (delayed coding, rANS and arithmetic
+ * coding), so that a codec can be picked at runtime. A compressed file starts with the container
+ * header, i.e. kContainerMagic, kContainerVersion and the codec id, which is one of
+ * kDelayedCodingBackend, kRansBackend or kArithmeticCodingBackend.
+ */
+class TupleCompressor {
+ public:
+  virtual ~TupleCompressor() = default;
+
+  /**
+   * Once the structure of attributes are learned, or enter compression stage, a
+   * full dataset scan is necessary.
+   *
+   * @return whether a full dataset scan is needed.
+   */
+  virtual bool RequireFullPass() const = 0;
+
+  /**
+   * If compressor needs a full scan of dataset when learning, return true.
+   *
+   * @return whether a full dataset scan is needed.
+   */
+  virtual bool RequireMoreIterationsForLearning() const = 0;
+
+  /**
+   * Feed a tuple to model learning.
+   *
+   * @param tuple basic unit of structural dataset, i.e. tuple.
+   */
+  virtual void LearnTuple(const AttrVector &tuple) = 0;
+
+  /**
+   * Compress a tuple.
+   *
+   * @param tuple basic unit of structure dataset
+   */
+  virtual void CompressTuple(AttrVector &tuple) = 0;
+
+  /**
+   * Compress tuples in [begin, end). By default tuples are compressed one by one.
+   *
+   * @param begin first tuple to be compressed
+   * @param end one past the last tuple to be compressed
+   * @param num_threads number of threads, a codec may ignore it
+   */
+  virtual void CompressTuples(std::vector<AttrVector>::iterator begin,
+                              std::vector<AttrVector>::iterator end, int /*num_threads*/) {
+    for (auto it = begin; it != end; ++it) CompressTuple(*it);
+  }
+
+  /**
+   * Set enum dictionaries, i.e. the enum values of categorical attributes. They
+   * are stored in the compressed file, it must be called before learning ends.
+   *
+   * @param dicts enum values of each attribute
+   */
+  virtual void SetEnumDictionaries(const std::vector<BiMap> &dicts) = 0;
+
+  /**
+   * Learning stage ends, write down models.
+   */
+  virtual void EndOfLearning() = 0;
+
+  /**
+   * Compression ends, write down what is left.
+   */
+  virtual void EndOfCompress() = 0;
+};
+
+/**
+ * A tuple decompressor, it is implemented by every codec. Use ReadCodecId() to find out which
+ * decompressor can read a file.
+ */
+class TupleDecompressor {
+ public:
+  virtual ~TupleDecompressor() = default;
+
+  /**
+   * Init a decompressor, including loading models and the index.
+   */
+  virtual void Init() = 0;
+
+  /**
+   * Get number of tuples in the compressed file, it is known once Init() is called.
+   *
+   * @return number of tuples
+   */
+  virtual int GetNumTotalTuples() const = 0;
+
+  /**
+   * Get enum dictionaries stored in the compressed file, they are known once Init() is called.
+   *
+   * @return enum values of each attribute
+   */
+  virtual const std::vector<BiMap> &GetEnumDictionaries() const = 0;
+
+  /**
+   * Random Access. Locate tuple position.
+   *
+   * @param tuple_idx index of accessed tuple
+   */
+  virtual void LocateTuple(uint32_t tuple_idx) = 0;
+
+  /**
+   * Random Access. Decompress a batch of tuples, tuple indices may come in any order and
+   * repeat. By default tuples are located and decompressed one by one. LocateTuple() must be
+   * called before the next ReadNextTuple().
+   *
+   * @param tuple_ids indices of accessed tuples
+   * @param num number of accessed tuples
+   * @param[out] tuples tuples[i] is the tuple of tuple_ids[i]
+   */
+  virtual void ReadTuples(const uint32_t *tuple_ids, size_t num, AttrVector *tuples) {
+    for (size_t i = 0; i < num; ++i) {
+      LocateTuple(tuple_ids[i]);
+      while (HasNext()) ReadNextTuple(&tuples[i]);
+    }
+  }
+
+  /**
+   * Keep decoded blocks of random access in memory, so that lookups into a hot block do not
+   * decode it again. It covers LocateTuple() and ReadTuples(). By default nothing is cached.
+   *
+   * @param capacity_bytes byte budget of decoded tuples, 0 disables the cache
+   */
+  virtual void SetBlockCache(size_t /*capacity_bytes*/) {}
+
+  /**
+   * @return hit and miss counters of the block cache
+   */
+  virtual BlockCacheStats GetBlockCacheStats() const { return {}; }
+
+  /**
+   * Decompress next tuple, existence of next tuple should be checked before
+   * calling this function.
+   *
+   * @param[out] tuple decompressed result
+   */
+  virtual void ReadNextTuple(AttrVector *tuple) = 0;
+
+  /**
+   * Check if next tuple is existed.
+   *
+   * @return return true if next tuple exists; or return false
+   */
+  virtual bool HasNext() const = 0;
+
+  /**
+   * Decompress the whole dataset, right after Init().
+   *
+   * @param num_threads number of threads, a codec may ignore it
+   * @param callback it is called with (thread id, tuple index, tuple) for each tuple
+   */
+  virtual void ParallelScan(int num_threads,
+                            const std::function<void(int, size_t, const AttrVector &)> &callback) = 0;
+
+  /**
+   * Decompress the whole dataset in tuple order with ParallelScan().
+   *
+   * @param[out] tuples decompressed tuples
+   * @param num_threads number of threads
+   */
+  void ReadAllTuples(std::vector<AttrVector> *tuples, int num_threads) {
+    tuples->assign(GetNumTotalTuples(), AttrVector(0));
+    ParallelScan(num_threads, [tuples](int, size_t tuple_idx, const AttrVector &tuple) {
+      (*tuples)[tuple_idx] = tuple;
+    });
+  }
+};
+
+/**
+ * Read the codec id of a compressed file.
+ *
+ * @param file_name compressed file address
+ * @return codec id, or -1 if the file cannot be read or is not a compressed file
+ */
+inline int ReadCodecId(const char *file_name) {
+  std::ifstream fin(file_name, std::ios::binary);
+  unsigned char bytes[8];
+  if (!fin.read(reinterpret_cast<char *>(bytes), 8)) return -1;
+  uint32_t magic = (bytes[0] << 24) | (bytes[1] << 16) | (bytes[2] << 8) | bytes[3];
+  if (magic != kContainerMagic) return -1;
+  return (bytes[6] << 8) | bytes[7];
+}
+}  // namespace db_compress
+
+#endif
@@ -10,6 +10,7 @@
 #include <vector>
 
 #include "base.h"
+#include "codec.h"
 #include "data_io.h"
 #include "index.h"
 #include "model.h"
@@ -20,9 +21,22 @@
 namespace db_compress {
 
 /**
- * The compressor for relational dataset.
+ * One step of a tuple encode plan, it turns one attribute into probability
+ * intervals. The encode function is chosen by attribute type when the plan is
+ * built, and squid_ is pre-bound if the model has no predictor.
  */
-class RelationCompressor {
+struct TupleEncodeStep {
+  void (*encode_)(const TupleEncodeStep &step, const AttrVector &tuple,
+                  std::vector<Branch *> &prob_intervals, int &prob_intervals_index);
+  SquIDModel *model_;
+  void *squid_;
+  size_t target_var_;
+};
+
+/**
+ * The compressor for relational dataset, with delayed coding or rANS backend.
+ */
+class RelationCompressor : public TupleCompressor {
  public:
   /**
    * Create a new Compressor.
@@ -33,9 +47,29 @@ class RelationCompressor {
    * @param config learning config
    * @param block_size once probability intervals number is larger than block
    * size, flush them
+   * @param coding_config delayed coding engine, i.e. interleaved states,
+   * precision and renormalization width. It must be valid.
+   *
+   * Block size and delayed coding engine are recorded in the file header.
    */
   RelationCompressor(const char *output_file, const Schema &schema, const CompressionConfig &config,
-                     int block_size);
+                     int block_size, const DelayedCodingConfig &coding_config = DelayedCodingConfig());
+
+  /**
+   * Create a new Compressor that compresses into memory. Once EndOfCompress()
+   * is called, output holds the whole compressed table, it can be
+   * decompressed by a RelationDecompressor created over it.
+   *
+   * @param output compressed table, it must outlive the compressor
+   * @param schema attributes types and ordering are recorded in schema
+   * @param config learning config
+   * @param block_size once probability intervals number is larger than block
+   * size, flush them
+   * @param coding_config delayed coding engine. It must be valid.
+   */
+  RelationCompressor(std::vector<unsigned char> *output, const Schema &schema,
+                     const CompressionConfig &config, int block_size,
+                     const DelayedCodingConfig &coding_config = DelayedCodingConfig());
 
   /**
    * Once the structure of attributes are learned, or enter compression stage, a
@@ -43,7 +77,9 @@ class RelationCompressor {
    *
    * @return whether a full dataset scan is needed.
    */
-  bool RequireFullPass() const { return (compressor_stage_ > 0 || learner_->RequireFullPass()); };
+  bool RequireFullPass() const override {
+    return (compressor_stage_ > 0 || learner_->RequireFullPass());
+  }
 
   /**
    * If compressor needs a full scan of dataset when learning, return true. That
@@ -52,7 +88,7 @@ class RelationCompressor {
    *
    * @return whether a full dataset scan is needed.
    */
-  bool RequireMoreIterationsForLearning() const { return compressor_stage_ == 0; }
+  bool RequireMoreIterationsForLearning() const override { return compressor_stage_ == 0; }
 
   /**
    * This function is for structure learning. In the learning stage, we need
@@ -60,7 +96,7 @@ class RelationCompressor {
    *
    * @param tuple basic unit of structural dataset, i.e. tuple.
    */
-  void LearnTuple(const AttrVector &tuple) {
+  void LearnTuple(const AttrVector &tuple) override {
     learner_->FeedTuple(tuple);
     num_tuples_++;
   }
@@ -70,17 +106,40 @@ class RelationCompressor {
    *
    * @param tuple basic unit of structure dataset
    */
-  void CompressTuple(AttrVector &tuple);
+  void CompressTuple(AttrVector &tuple) override;
+
+  /**
+   * Compress tuples in [begin, end) with a pool of worker threads. Models keep
+   * cross-tuple state (markov state, local dictionary), so tuples are still
+   * turned into probability intervals in order on the calling thread; every
+   * sealed block is then delayed coded by a worker, and encoded blocks are
+   * written back in block order. The output is byte-identical to calling
+   * CompressTuple() on each tuple.
+   *
+   * @param begin first tuple to be compressed
+   * @param end one past the last tuple to be compressed
+   * @param num_threads number of delayed coding workers, 1 means serial
+   */
+  void CompressTuples(std::vector<AttrVector>::iterator begin,
+                      std::vector<AttrVector>::iterator end, int num_threads) override;
+
+  /**
+   * Enum dictionaries are stored in the enum section of the compressed table, which is written
+   * once compression ends.
+   *
+   * @param dicts enum values of each attribute
+   */
+  void SetEnumDictionaries(const std::vector<BiMap> &dicts) override { enum_dicts_ = dicts; }
 
   /**
    * Learning stage ends, write down models.
    */
-  void EndOfLearning();
+  void EndOfLearning() override;
 
   /**
    * Compression ends, write down left probability intervals.
    */
-  void EndOfCompress();
+  void EndOfCompress() override;
 
  private:
   Schema schema_;
@@ -88,27 +147,80 @@ class RelationCompressor {
   size_t num_tuples_;
   IndexCreator index_creator_;
   std::string output_file_;
+  // if it is not null, the compressed table goes to memory instead of output_file_
+  std::vector<unsigned char> *sink_{nullptr};
+  std::vector<BiMap> enum_dicts_;
   const int kBlockSizeThreshold_;
+  const DelayedCodingConfig coding_config_;
   int compressor_stage_;
 
   // IO
   std::unique_ptr<SequenceByteWriter> byte_writer_;
   BitString bit_string_;
+  // byte offsets of sections, they are recorded in the footer
+  uint64_t model_offset_;
+  uint64_t data_offset_;
 
   // delayed coding
   std::vector<Branch *> prob_intervals_;
   int prob_intervals_index_;
   std::vector<bool> is_virtual_;
+  // decoder checkpoints of the current block, recorded every checkpoint_tuples_ tuples unless
+  // it is 0. Models with cross-tuple state cannot resume at a checkpoint, they record none.
+  int checkpoint_tuples_{0};
+  int num_block_tuples_{0};
+  std::vector<int> checkpoint_intervals_;
+  std::vector<DecoderCheckpoint> checkpoints_;
 
   // model learning
   std::vector<std::unique_ptr<SquIDModel>> model_;
   std::vector<size_t> attr_order_;
+  // encode steps of all attributes, built once models are learned
+  std::vector<TupleEncodeStep> plan_;
+
+  /**
+   * A sealed block in CompressTuples(), it waits for a worker to encode it and
+   * then for the writer to flush it.
+   */
+  struct PendingBlock {
+    std::vector<Branch *> prob_intervals_;
+    int prob_intervals_index_{0};
+    size_t num_tuples_{0};
+    std::vector<int> checkpoint_intervals_;
+    std::vector<DecoderCheckpoint> checkpoints_;
+    std::vector<uint16_t> bits_;
+    bool encoded_{false};
+  };
 
   /**
    * Once probability intervals number is larger than block size, flush and
    * encode them.
    */
   void WriteProbInterval();
+
+  /**
+   * Build the tuple encode plan from learned models and attribute ordering.
+   */
+  void BuildPlan();
+
+  /**
+   * Append probability intervals of a tuple to the current block.
+   *
+   * @param tuple basic unit of structure dataset
+   */
+  void ModelTuple(AttrVector &tuple);
+
+  /**
+   * Start a new block, after the current one is sealed.
+   */
+  void ResetBlock();
+
+  /**
+   * Write down an encoded block and its index entry.
+   *
+   * @param block an encoded block
+   */
+  void WritePendingBlock(const PendingBlock &block);
 };
 }  // namespace db_compress
 
@@ -6,8 +6,10 @@
 #ifndef DATA_IO_H
 #define DATA_IO_H
 
+#include <chrono>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <vector>
 
 #include "base.h"
@@ -16,7 +18,9 @@ namespace db_compress {
 
 /**
  * SequenceByteWriter is a utility class that can be used to write bit strings
- * in sequence.
+ * in sequence. Bits are gathered in a 64-bit accumulator and moved to a large
+ * output buffer 32 bits at a time. Runs of byte-aligned 16-bit words, which
+ * are nearly all of the output, skip the accumulator.
  */
 class SequenceByteWriter {
  public:
@@ -27,6 +31,14 @@ class SequenceByteWriter {
    */
   explicit SequenceByteWriter(const std::string &file_name);
 
+  /**
+   * Create a SequenceByteWriter that appends to memory.
+   *
+   * @param sink output bytes are appended to it, all of them are there once
+   * the writer is deconstructed
+   */
+  explicit SequenceByteWriter(std::vector<unsigned char> *sink);
+
   /**
    * Deconstruct a SequenceByteWriter.
    */
@@ -73,19 +85,91 @@ class SequenceByteWriter {
    */
   void WriteUint64(uint64_t data);
 
+  /**
+   * Write an unsigned number in 7-bit groups, least significant group first. The
+   * highest bit of a byte tells whether another byte follows.
+   *
+   * @param data the number, values below 128 take one byte
+   */
+  void WriteVarint(uint64_t data) {
+    for (; data >= 0x80; data >>= 7) WriteBits(static_cast<uint32_t>(data & 0x7F) | 0x80, 8);
+    WriteBits(static_cast<uint32_t>(data), 8);
+  }
+
+  /**
+   * Write 16-bit words in order, each one most significant byte first. It is
+   * the same as calling Write16Bit() on each word.
+   *
+   * @param words first word
+   * @param num number of words
+   */
+  void WriteWords(const uint16_t *words, size_t num);
+
+  /**
+   * Pad zeros up to the next byte boundary.
+   */
+  void AlignToByte() {
+    if (acc_bits_ & 7) WriteBits(0, 8 - (acc_bits_ & 7));
+  }
+
+  /**
+   * Position of next bit to write, it counts every bit written by this writer.
+   *
+   * @return number of bits written so far
+   */
+  uint64_t Tellp() const { return ((flushed_bytes_ + buffer_pos_) << 3) + acc_bits_; }
+
   uint64_t GetNumBits() { return num_bits_; }
 
   void ClearNumBits() { num_bits_ = 0; }
 
  private:
   std::ofstream file_;
-  // 64 KB buffer
-  char buffer_[65537];
-  // 0 - 8191 * 8 (8192 * 8)
-  uint64_t bits_counter_;
+  // if it is not null, output goes to memory instead of file_
+  std::vector<unsigned char> *sink_;
+  // kWriterBufferSize bytes, they are flushed by one write
+  std::vector<char> buffer_;
+  size_t buffer_pos_;
+  // bytes that have left buffer_
+  uint64_t flushed_bytes_{0};
+  // the lower acc_bits_ bits are not in buffer yet, acc_bits_ < 32 between calls
+  uint64_t acc_;
+  int acc_bits_;
 
   // stats
   uint64_t num_bits_{0};
+
+  /**
+   * Append the least significant (len) bits of val.
+   *
+   * @param val bits to be written
+   * @param len number of bits, no more than 32
+   */
+  inline void WriteBits(uint32_t val, int len) {
+    num_bits_ += len;
+    acc_ = (acc_ << len) | (val & ((static_cast<uint64_t>(1) << len) - 1));
+    acc_bits_ += len;
+    if (acc_bits_ >= 32) {
+      acc_bits_ -= 32;
+      if (buffer_pos_ + 4 > buffer_.size()) FlushBuffer();
+      const uint32_t out = acc_ >> acc_bits_;
+      buffer_[buffer_pos_++] = static_cast<char>(out >> 24);
+      buffer_[buffer_pos_++] = static_cast<char>(out >> 16);
+      buffer_[buffer_pos_++] = static_cast<char>(out >> 8);
+      buffer_[buffer_pos_++] = static_cast<char>(out);
+      acc_ &= (static_cast<uint64_t>(1) << acc_bits_) - 1;
+    }
+  }
+
+  /**
+   * Move whole bytes of the accumulator into buffer.
+   */
+  void DrainAccumulator();
+
+  /**
+   * Write buffer to file or sink.
+   */
+  void FlushBuffer();
 };
 
 /**
@@ -177,23 +261,143 @@ class SequenceByteWriter {
 // };
 
 /**
- * ByteReader firstly loads all data into memory, then output data from memory.
+ * How a mapped file is going to be read, it is passed to madvise(). kDontNeed
+ * drops resident pages, they are read from the file again once touched.
  */
-class ByteReader {
+enum class MapAdvice { kNormal, kSequential, kRandom, kWillNeed, kDontNeed };
+
+/**
+ * ByteSource is the read-only memory a ByteReader reads from. The bytes are
+ * followed by at least kMappedFilePadding zero bytes, so readers may look a
+ * few bytes past the end without checking.
+ */
+class ByteSource {
+ public:
+  virtual ~ByteSource() = default;
+
+  const unsigned char *Data() const { return data_; }
+
+  size_t Size() const { return size_; }
+
+  /**
+   * Tell how a range of bytes is going to be read. Only a mapped file makes
+   * use of it.
+   *
+   * @param offset first byte of range
+   * @param length number of bytes
+   * @param advice expected access pattern
+   */
+  virtual void Advise(size_t /*offset*/, size_t /*length*/, MapAdvice /*advice*/) const {}
+
+ protected:
+  const unsigned char *data_{nullptr};
+  size_t size_{0};
+};
+
+/**
+ * MappedFile is a read-only memory mapping of a file.
+ */
+class MappedFile : public ByteSource {
+ public:
+  /**
+   * Map a file. It throws IOException if the file cannot be opened or mapped.
+   *
+   * @param file_name file address
+   * @param populate if true, pages are read ahead when mapping (MAP_POPULATE)
+   * @param advice expected access pattern
+   */
+  MappedFile(const std::string &file_name, bool populate, MapAdvice advice);
+
+  /**
+   * Unmap the file.
+   */
+  ~MappedFile() override;
+
+  /**
+   * Pass advice to madvise(), for the pages lying entirely in the range, so
+   * that pages shared with neighbouring ranges are not dropped.
+   */
+  void Advise(size_t offset, size_t length, MapAdvice advice) const override;
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+ private:
+  void *addr_;
+  size_t length_;
+};
+
+/**
+ * MemoryBuffer owns bytes in memory, e.g. a compressed table that never goes
+ * to disk.
+ */
+class MemoryBuffer : public ByteSource {
  public:
-  std::vector<unsigned char> stream_;
+  /**
+   * Take over bytes, the padding is appended to them.
+   *
+   * @param bytes bytes to be read
+   */
+  explicit MemoryBuffer(std::vector<unsigned char> bytes) : bytes_(std::move(bytes)) {
+    size_ = bytes_.size();
+    bytes_.resize(size_ + kMappedFilePadding, 0);
+    data_ = bytes_.data();
+  }
+
+ private:
+  std::vector<unsigned char> bytes_;
+};
 
+/**
+ * ByteReader reads bits from a memory mapped file or from memory, nothing is
+ * copied. Copies of a ByteReader share the bytes, and each copy has its own
+ * read position, so a copy is a cheap cursor for another thread.
+ */
+class ByteReader {
+ public:
   /**
-   * Create a in-memory byte reader
+   * Create a byte reader over a memory mapped file.
    *
    * @param file_name compressed file address
+   * @param populate if true, the whole file is paged in when mapping
+   * @param advice expected access pattern
+   */
+  explicit ByteReader(const std::string &file_name, bool populate = false,
+                      MapAdvice advice = MapAdvice::kNormal)
+      : file_(std::make_shared<const MappedFile>(file_name, populate, advice)),
+        data_(file_->Data()) {}
+
+  /**
+   * Create a byte reader over bytes in memory.
+   *
+   * @param bytes bytes to be read, e.g. output of an in-memory compressor
+   */
+  explicit ByteReader(std::vector<unsigned char> bytes)
+      : file_(std::make_shared<const MemoryBuffer>(std::move(bytes))), data_(file_->Data()) {}
+
+  /**
+   * Get all bytes.
+   *
+   * @return first byte of file
    */
-  explicit ByteReader(const std::string &file_name) : fin_(file_name, std::ios::binary) {
-    if (!fin_.is_open()) std::cout << "Cannot open file " << file_name << "\n";
-    while (!fin_.eof()) stream_.push_back(fin_.get());
-    // pop the last byte '255'.
-    stream_.pop_back();
-    fin_.close();
+  const unsigned char *Data() const { return data_; }
+
+  /**
+   * Get file size.
+   *
+   * @return number of bytes
+   */
+  size_t Size() const { return file_->Size(); }
+
+  /**
+   * Tell how a range of bytes is going to be read, see MapAdvice.
+   *
+   * @param offset first byte of range
+   * @param length number of bytes
+   * @param advice expected access pattern
+   */
+  void Advise(size_t offset, size_t length, MapAdvice advice) const {
+    file_->Advise(offset, length, advice);
   }
 
   /**
@@ -202,9 +406,9 @@ class ByteReader {
    * @return return one bit.
    */
   bool ReadBit() {
-    uint32_t byte_idx = position_ >> 3;
+    size_t byte_idx = position_ >> 3;
     uint8_t bit_idx = position_ & 7;
-    bool ret = (stream_[byte_idx] >> (7 - bit_idx)) & 1;
+    bool ret = (data_[byte_idx] >> (7 - bit_idx)) & 1;
 
     position_++;
     return ret;
@@ -216,13 +420,13 @@ class ByteReader {
    * @return return a unsigned char of 8 bits
    */
   unsigned char ReadByte() {
-    uint32_t byte_idx = position_ >> 3;
+    size_t byte_idx = position_ >> 3;
     uint8_t bit_idx = position_ & 7;
     uint8_t ret;
     if (bit_idx == 0)
-      ret = stream_[byte_idx];
+      ret = data_[byte_idx];
     else
-      ret = (stream_[byte_idx] << bit_idx) | (stream_[byte_idx + 1] >> (8 - bit_idx));
+      ret = (data_[byte_idx] << bit_idx) | (data_[byte_idx + 1] >> (8 - bit_idx));
 
     position_ += 8;
     return ret;
@@ -235,10 +439,10 @@ class ByteReader {
    * bits.
    */
   inline unsigned int Read16Bit() {
-    uint32_t byte_idx = position_ >> 3;
+    size_t byte_idx = position_ >> 3;
     uint8_t bit_idx = position_ & 7;
-    uint16_t ret = (stream_[byte_idx] << (bit_idx + 8)) | (stream_[byte_idx + 1] << bit_idx);
-    if (bit_idx != 0) ret |= stream_[byte_idx + 2] >> (8 - bit_idx);
+    uint16_t ret = (data_[byte_idx] << (bit_idx + 8)) | (data_[byte_idx + 1] << bit_idx);
+    if (bit_idx != 0) ret |= data_[byte_idx + 2] >> (8 - bit_idx);
 
     position_ += 16;
     return ret;
@@ -248,8 +452,8 @@ class ByteReader {
    * If there is no bit read requirement, we can be faster.
    */
   inline uint32_t Read16BitFast() {
-    uint32_t byte_idx = position_ >> 3;
-    uint16_t ret = (stream_[byte_idx] << 8) | stream_[byte_idx + 1];
+    size_t byte_idx = position_ >> 3;
+    uint16_t ret = (data_[byte_idx] << 8) | data_[byte_idx + 1];
     position_ += 16;
     return ret;
   }
@@ -272,6 +476,20 @@ class ByteReader {
     for (int i = 0; i < 4; ++i) bytes[i] = ReadByte();
   }
 
+  /**
+   * Read an unsigned number written by SequenceByteWriter::WriteVarint().
+   *
+   * @return the number
+   */
+  uint64_t ReadVarint() {
+    uint64_t ret = 0;
+    for (int shift = 0;; shift += 7) {
+      unsigned char byte = ReadByte();
+      ret |= static_cast<uint64_t>(byte & 0x7F) << shift;
+      if (!(byte & 0x80)) return ret;
+    }
+  }
+
   /**
    * Read an uint_64 number
    */
@@ -296,7 +514,7 @@ class ByteReader {
     if (way == std::ios_base::beg)
       position_ = (num_bytes * 8) + num_bits;
     else if (way == std::ios_base::end)
-      position_ = ((stream_.size()) << 3) + (num_bytes * 8) + num_bits;
+      position_ = (Size() << 3) + (num_bytes * 8) + num_bits;
     else if (way == std::ios_base::cur)
       position_ += (num_bytes * 8) + num_bits;
   }
@@ -306,10 +524,59 @@ class ByteReader {
   inline uint64_t Tellg() { return position_; }
 
  private:
-  std::ifstream fin_;
+  std::shared_ptr<const ByteSource> file_;
+  const unsigned char *data_;
   uint64_t position_{0};
 };
 
+/**
+ * ReadAhead asks the kernel to page in bytes ahead of a sequential reader, so
+ * that disk reads overlap with decoding. MADV_WILLNEED starts the reads and
+ * returns, so no thread is needed. The window covers about kReadAheadMicros of
+ * decoding at the measured rate, within [kReadAheadMinBytes, kReadAheadMaxBytes].
+ */
+class ReadAhead {
+ public:
+  /**
+   * Create a read-ahead over a range of bytes, nothing is requested until the
+   * first call of Advance().
+   *
+   * @param byte_reader reader of the range
+   * @param begin first byte of range
+   * @param end one past the last byte of range
+   */
+  ReadAhead(const ByteReader &byte_reader, uint64_t begin, uint64_t end)
+      : byte_reader_(byte_reader),
+        end_(end),
+        requested_(begin),
+        window_(kReadAheadMinBytes),
+        last_pos_(begin),
+        last_time_(std::chrono::steady_clock::now()) {}
+
+  /**
+   * The reader has reached pos. Once less than half a window is requested
+   * ahead of it, the window is resized and requested again.
+   *
+   * @param pos next byte to read
+   */
+  void Advance(uint64_t pos) {
+    if (requested_ >= end_ || pos + window_ / 2 < requested_) return;
+    Refill(pos);
+  }
+
+ private:
+  ByteReader byte_reader_;
+  uint64_t end_;
+  // bytes in [begin, requested_) have been requested
+  uint64_t requested_;
+  uint64_t window_;
+  // where and when the window was last requested
+  uint64_t last_pos_;
+  std::chrono::steady_clock::time_point last_time_;
+
+  void Refill(uint64_t pos);
+};
+
 }  // namespace db_compress
 
 #endif
@@ -7,12 +7,15 @@
 #define DECOMPRESSION_H
 
 #include <fstream>
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include "base.h"
+#include "block_cache.h"
 #include "categorical_model.h"
+#include "codec.h"
 #include "data_io.h"
 #include "index.h"
 #include "markov_model.h"
@@ -23,12 +26,29 @@
 
 namespace db_compress {
 
+/**
+ * One step of a tuple decode plan, it decodes one attribute. The decode
+ * function is chosen by attribute type when the plan is built, and squid_ is
+ * pre-bound if the model has no predictor. Plans are built for the decoder of
+ * the backend, i.e. Decoder or RansDecoder.
+ */
+template <class Engine>
+struct TupleDecodeStep {
+  void (*decode_)(const TupleDecodeStep &step, Engine *decoder, ByteReader *byte_reader,
+                  AttrVector *tuple);
+  SquIDModel *model_;
+  void *squid_;
+  size_t attr_index_;
+};
+template <class Engine>
+using TupleDecodePlan = std::vector<TupleDecodeStep<Engine> >;
+
 /**
  * It is used to recovered information from compressed binary file.
  * First, it needs to know where to start decompression; Then, decompress.csv next
  * tuple with ReadNextTuple function until all needed tuples have been given.
  */
-class RelationDecompressor {
+class RelationDecompressor : public TupleDecompressor {
  public:
   int num_total_tuples_;
 
@@ -40,22 +60,62 @@ class RelationDecompressor {
    * @param tuple_idx it indicates where to start decompress.csv dataset
    * @param decompress_num in indicates how many tuples to be decompress.csv
    * @param block_size once decompressed tuple number is larger than block size,
-   * decoder need initialization.
+   * decoder need initialization. The block size recorded in the file header
+   * takes precedence.
    */
   RelationDecompressor(const char *compressed_file_name, Schema schema, int block_size);
 
+  /**
+   * Create a decompressor over a compressed table in memory, e.g. the output
+   * of an in-memory RelationCompressor.
+   *
+   * @param compressed compressed table, it is taken over without copy
+   * @param schema schema contains attributes types and ordering
+   * @param block_size the block size recorded in the table takes precedence
+   */
+  RelationDecompressor(std::vector<unsigned char> compressed, Schema schema, int block_size);
+
   /**
    * Init a decompressor. including loading squid models from disks and finding
    * the position of decompression starts (random access).
    */
-  void Init();
+  void Init() override;
 
   /**
-   * Random Access. Locate tuple position.
+   * Random Access. Locate tuple position. Decoding starts at the nearest
+   * checkpoint before the tuple if the file has checkpoints, otherwise at the
+   * block start. If the tuple is in the block cache, only the located tuple is
+   * read by ReadNextTuple().
    *
    * @param tuple_idx index of accessed tuple
    */
-  void LocateTuple(uint32_t tuple_idx);
+  void LocateTuple(uint32_t tuple_idx) override;
+
+  /**
+   * Keep decoded blocks of random access in a block cache.
+   *
+   * @param capacity_bytes byte budget of decoded tuples, 0 disables the cache
+   */
+  void SetBlockCache(size_t capacity_bytes) override;
+
+  /**
+   * @return hit and miss counters of the block cache
+   */
+  BlockCacheStats GetBlockCacheStats() const override;
+
+  /**
+   * Random Access. Tuple indices are sorted and grouped by block, every block
+   * is decoded once, up to the last tuple wanted from it. Decoding skips ahead
+   * to checkpoints in between. Blocks are located by interleaved index
+   * searches, and what the next blocks read is requested while one is decoded.
+   * Tuples found in the block cache are not decoded, and decoded tuples are
+   * cached, see SetBlockCache().
+   *
+   * @param tuple_ids indices of accessed tuples
+   * @param num number of accessed tuples
+   * @param[out] tuples tuples[i] is the tuple of tuple_ids[i]
+   */
+  void ReadTuples(const uint32_t *tuple_ids, size_t num, AttrVector *tuples) override;
 
   /**
    * Decompress next tuple, existence of next tuple should be checked before
@@ -63,21 +123,51 @@ class RelationDecompressor {
    *
    * @param[out] tuple decompressed result
    */
-  void ReadNextTuple(AttrVector *tuple);
+  void ReadNextTuple(AttrVector *tuple) override;
 
   /**
-   * Random Access.
+   * Random Access into a table of one tuple per block, i.e. block size 1.
    *
+   * @param tuple_idx index of accessed tuple
    * @param[out] tuple decompressed result
    */
   void ReadTargetTuple(size_t tuple_idx, AttrVector *tuple);
 
+  /**
+   * Decompress the whole dataset with a pool of threads. Blocks are split into
+   * num_threads contiguous ranges, and each thread decodes its range with its
+   * own models, decoder and byte reader. A thread delivers its tuples in order,
+   * different threads deliver tuples concurrently.
+   *
+   * Models with cross-tuple state (markov state, local dictionary) are reset at
+   * every block start, so that any block can be decoded on its own.
+   *
+   * @param num_threads number of threads
+   * @param callback it is called with (thread id, tuple index, tuple) for each tuple
+   */
+  void ParallelScan(int num_threads,
+                    const std::function<void(int, size_t, const AttrVector &)> &callback) override;
+
   /**
    * Check if next tuple is existed.
    *
    * @return return true if next tuple exists; or return false
    */
-  bool HasNext() const { return num_converted_tuples_ < num_todo_tuples_; }
+  bool HasNext() const override { return num_converted_tuples_ < num_todo_tuples_; }
+
+  /**
+   * Get enum dictionaries stored in the compressed file.
+   *
+   * @return enum values of each attribute
+   */
+  const std::vector<BiMap> &GetEnumDictionaries() const override { return enum_dicts_; }
+
+  /**
+   * Get number of tuples in the compressed file.
+   *
+   * @return number of tuples
+   */
+  int GetNumTotalTuples() const override { return num_total_tuples_; }
 
   /**
    * Get the index of last decompressed tuple in a dataset
@@ -88,21 +178,120 @@ class RelationDecompressor {
 
  private:
   Schema schema_;
-  IndexReader index_reader_;
 
   int num_converted_tuples_, num_todo_tuples_;
 
   // where to start decompress.csv, and how many tuples needed
   uint32_t tuple_idx_;
 
-  const int kBlockSizeThreshold;
+  // delayed coding params, they are recorded in the file header
+  int block_size_threshold_;
+  DelayedCodingConfig coding_config_;
   ByteReader byte_reader_;
+  // the index section is located by the footer of the compressed table
+  IndexReader index_reader_;
+  std::vector<BiMap> enum_dicts_;
   std::vector<std::unique_ptr<SquIDModel> > model_;
   std::vector<size_t> attr_order_;
+  // the backend is chosen once at Init(), only its decoder and plan are used
+  bool rans_{false};
   Decoder decoder_;
+  RansDecoder rans_decoder_;
+
+  // where block data starts in the compressed file, in bits
+  uint64_t data_pos_;
+  // length of block data in bytes
+  uint64_t data_size_;
+  // whether block data has been advised for random access
+  bool random_access_{false};
+  // block data ahead of ReadNextTuple() is requested while it is not random access
+  std::unique_ptr<ReadAhead> read_ahead_;
+  uint64_t num_bytes_;
+  // decoded blocks of random access, it is null unless SetBlockCache() is called
+  std::unique_ptr<BlockCache> block_cache_;
+  // the located tuple found in the block cache
+  const AttrVector *cached_tuple_{nullptr};
+  // tuples decoded so far from where decoding of the located tuple starts, i.e. a block start or
+  // a checkpoint, they are cached once the located tuple is read
+  std::vector<AttrVector> block_tuples_;
+  uint32_t run_start_;
+  // where models are located in the compressed file
+  uint64_t model_pos_;
+  // decode steps of all attributes
+  TupleDecodePlan<Decoder> plan_;
+  TupleDecodePlan<RansDecoder> rans_plan_;
+
+  /**
+   * Move to a block for random access, at its start or at one of its checkpoints.
+   *
+   * @param block_idx index of block
+   * @param checkpoint k for the k-th checkpoint of block, 0 for the block start
+   */
+  void SeekBlock(int block_idx, uint32_t checkpoint);
+
+  /**
+   * Start decoding a block at the current position, decoding states of the
+   * backend and models are reset.
+   */
+  void InitBlock();
+
+  /**
+   * Decompress the next tuple at the current position with the backend.
+   *
+   * @param[out] tuple decompressed result
+   */
+  void DecodeNext(AttrVector *tuple);
+
+  /**
+   * Request what a random access into a block reads first, ahead of SeekBlock(). It is the
+   * checkpoint where decoding of a tuple starts, or, with data, the first kLookupPrefetchLines
+   * cache lines of block data from there.
+   *
+   * @param block_idx index of block
+   * @param tuple_idx index of tuple
+   * @param data whether to request block data, its checkpoint must have been requested earlier
+   */
+  void PrefetchSeek(int block_idx, uint32_t tuple_idx, bool data) const;
+
+  /**
+   * Tell the mapping that block data is read at random, so that a point lookup
+   * only pages in the block it decodes instead of a read-ahead window.
+   */
+  void AdviseRandomAccess();
+
+  /**
+   * Read squid models of all attributes.
+   *
+   * @param byte_reader byte reader located at the first model
+   * @param[out] models loaded models
+   */
+  void ReadModels(ByteReader *byte_reader, std::vector<std::unique_ptr<SquIDModel> > *models);
 
-  int data_pos_;
-  uint32_t num_bytes_;
+  /**
+   * Build a tuple plan, one step per attribute in attribute ordering. The plan
+   * is bound to the given models.
+   *
+   * @param models squid models of all attributes
+   * @param[out] plan tuple plan
+   */
+  template <class Engine>
+  void BuildPlan(std::vector<std::unique_ptr<SquIDModel> > &models,
+                 TupleDecodePlan<Engine> *plan) const;
+
+  /**
+   * Decompress a tuple with given plan, decoder and byte reader.
+   *
+   * @param plan tuple plan
+   * @param decoder decoder of the backend
+   * @param byte_reader byte reader
+   * @param[out] tuple decompressed result
+   */
+  template <class Engine>
+  static inline void DecodeTuple(const TupleDecodePlan<Engine> &plan, Engine *decoder,
+                                 ByteReader *byte_reader, AttrVector *tuple) {
+    for (const TupleDecodeStep<Engine> &step : plan)
+      step.decode_(step, decoder, byte_reader, tuple);
+  }
 };
 
 }  // namespace db_compress
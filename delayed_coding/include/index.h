@@ -6,62 +6,241 @@
 #ifndef INDEX_H
 #define INDEX_H
 
+#include <algorithm>
+#include <cstdint>
 #include <memory>
-#include <unistd.h>
+#include <vector>
 
 #include "blitzcrank_exception.h"
 #include "data_io.h"
 
 namespace db_compress {
 /**
- * Indexer creator of squish, the core component of random access. It is used to
- * create a indexer file when compression. Length of compressed bits for each
- * tuple is recorded in temp.index file, called index table. After compression,
- * we concatenate temp.index with compressed binary file.
+ * A node of the Eytzinger layout of blocks, see BlockTables.
+ */
+struct EytzingerNode {
+  uint32_t first_tuple_;
+  uint32_t block_;
+};
+
+/**
+ * Lookup tables of blocks. They are built from the index section, or they are
+ * used in place from the index image, which is the same tables written flat.
+ */
+struct BlockTables {
+  // prefix sums of block lengths in 16-bit words, and of tuples in blocks
+  std::vector<uint64_t> block_bits_;
+  std::vector<uint32_t> block_tuples_;
+  // if every block but the last one holds stride_ tuples, the block of a tuple is a division;
+  // otherwise it is 0
+  uint32_t stride_ = 0;
+  // first tuples of blocks in Eytzinger layout, i.e. a complete binary search tree stored
+  // breadth first from index 1, so that the top levels share cache lines. It is empty if
+  // blocks have a fixed stride.
+  std::vector<EytzingerNode> eytzinger_;
+
+  /**
+   * Read the index section, then build the lookup.
+   *
+   * @param byte_reader reader located at the index section
+   */
+  void Read(ByteReader *byte_reader) {
+    uint32_t num_block = byte_reader->ReadUint32();
+    block_bits_.assign(num_block + 1, 0);
+    block_tuples_.assign(num_block + 1, 0);
+    for (uint32_t i = 0; i < num_block; ++i) {
+      block_bits_[i + 1] = block_bits_[i] + byte_reader->ReadVarint();
+      block_tuples_[i + 1] = block_tuples_[i] + static_cast<uint32_t>(byte_reader->ReadVarint());
+    }
+    BuildLookup();
+  }
+
+  /**
+   * Detect fixed-stride blocks, or build the Eytzinger layout of blocks.
+   */
+  void BuildLookup() {
+    const uint32_t num_block = static_cast<uint32_t>(block_tuples_.size()) - 1;
+    stride_ = num_block > 0 ? block_tuples_[1] : 0;
+    for (uint32_t i = 1; stride_ > 0 && i < num_block; ++i) {
+      uint32_t num_tuples = block_tuples_[i + 1] - block_tuples_[i];
+      if (num_tuples != stride_ && (i != num_block - 1 || num_tuples > stride_)) stride_ = 0;
+    }
+    eytzinger_.clear();
+    if (stride_ > 0) return;
+
+    eytzinger_.resize(num_block + 1);
+    uint32_t block_idx = 0;
+    FillEytzinger(1, &block_idx);
+  }
+
+ private:
+  /**
+   * Fill the subtree rooted at node k with blocks in order.
+   *
+   * @param k root of subtree
+   * @param[in,out] block_idx next block to be placed
+   */
+  void FillEytzinger(size_t k, uint32_t *block_idx) {
+    if (k >= eytzinger_.size()) return;
+    FillEytzinger(2 * k, block_idx);
+    eytzinger_[k] = {block_tuples_[*block_idx], *block_idx};
+    ++*block_idx;
+    FillEytzinger(2 * k + 1, block_idx);
+  }
+};
+
+/**
+ * Indexer creator of squish, the core component of random access. Length of
+ * compressed words and number of tuples of each block are recorded in the
+ * index table, which is kept in memory during compression. After compression,
+ * the index table is appended to the compressed data, so that a compressed
+ * table is self-contained. Both numbers are varints, so a block of one tuple
+ * and less than 128 words takes 2 bytes, while blocks and tables of any size
+ * can be indexed.
  */
 class IndexCreator {
  public:
   /**
    * Create a index creator.
    */
-  IndexCreator()
-      : file_writer_(std::make_unique<SequenceByteWriter>(index_file_)),
-        num_block_(0),
-        last_block_size_(0) {}
+  IndexCreator() : num_block_(0), last_block_size_(0) {}
   /**
    * Write how many bits used for compressing last block. Block is a set of many
-   * probability intervals. Assumption: length and tuple number of every block
-   * are not longer than 65536.
+   * probability intervals.
    *
-   * @param length length of bits for a block
+   * @param length length of 16-bit words for a block
    * @param num_tuple compressed tuple number
    */
-  void WriteBlockInfo(uint32_t length, uint32_t num_tuple) {
-    file_writer_->Write16Bit(length);
-    file_writer_->Write16Bit(num_tuple - last_block_size_);
+  void WriteBlockInfo(uint64_t length, uint32_t num_tuple) {
+    PushVarint(length);
+    PushVarint(num_tuple - last_block_size_);
     if (block_size_ == -1) block_size_ = num_tuple - last_block_size_;
     last_block_size_ = num_tuple;
     num_block_++;
   }
 
   /**
-   * End of index creator, concatenate temp.index and compressed file into one
-   * final file.
+   * Record decoder checkpoints of the last block. Once checkpoints are enabled,
+   * it is called for every block right after WriteBlockInfo().
+   *
+   * @param checkpoints checkpoints of block, every checkpoint_tuples tuples from its second tuple
+   * @param num_states number of interleaved states
+   */
+  void WriteCheckpoints(const std::vector<DecoderCheckpoint> &checkpoints, int num_states) {
+    PushVarint(&checkpoints_, checkpoints.size());
+    for (const DecoderCheckpoint &checkpoint : checkpoints) {
+      PushVarint(&checkpoints_, checkpoint.interval_);
+      PushVarint(&checkpoints_, checkpoint.num_words_);
+      for (int i = 0; i < num_states; ++i) {
+        PushVarint(&checkpoints_, checkpoint.num_[i]);
+        PushVarint(&checkpoints_, checkpoint.den_[i]);
+        PushVarint(&checkpoints_, (static_cast<uint64_t>(checkpoint.virtual_bits_[i]) << 2) |
+                                      checkpoint.num_virtual_[i]);
+      }
+    }
+  }
+
+  /**
+   * Append the checkpoint section, i.e. the number of tuples between
+   * checkpoints and the number of states, then per block the number of
+   * checkpoints and the checkpoints, all as varints. It starts at a byte
+   * boundary.
+   *
+   * @param byte_writer writer of compressed data
+   * @param checkpoint_tuples number of tuples between checkpoints
+   * @param num_states number of interleaved states
+   * @return byte offset of the checkpoint section
+   */
+  uint64_t WriteCheckpointSection(SequenceByteWriter *byte_writer, int checkpoint_tuples,
+                                  int num_states) const {
+    byte_writer->AlignToByte();
+    uint64_t checkpoint_offset = byte_writer->Tellp() >> 3;
+    byte_writer->WriteVarint(checkpoint_tuples);
+    byte_writer->WriteVarint(num_states);
+    for (unsigned char byte : checkpoints_) byte_writer->WriteByte(byte);
+    return checkpoint_offset;
+  }
+
+  /**
+   * End of index creator, append the index section to compressed data. The index
+   * section starts at a byte boundary with the number of blocks, its offset is
+   * recorded in the footer of the compressed table.
    *
-   * @param output_file recovered dataset address
+   * @param byte_writer writer of compressed data
    */
-  void End() {
-    file_writer_->Write32Bit(num_block_);
-    file_writer_ = nullptr;
+  void End(SequenceByteWriter *byte_writer) {
+    byte_writer->AlignToByte();
+    byte_writer->Write32Bit(num_block_);
+    for (unsigned char byte : entries_) byte_writer->WriteByte(byte);
+  }
+
+  /**
+   * Append the index image, i.e. BlockTables written flat, so that a reader
+   * can use it in place instead of building it. It starts at an 8-byte
+   * boundary, every number is little endian:
+   * number of blocks (64 bits), stride (64 bits), block_bits_ (64 bits each),
+   * block_tuples_ (32 bits each, padded to 8 bytes), then eytzinger_ (32 + 32
+   * bits each) if stride is 0.
+   *
+   * @param byte_writer writer of compressed data
+   * @return byte offset of the index image
+   */
+  uint64_t WriteImage(SequenceByteWriter *byte_writer) const {
+    BlockTables tables;
+    tables.block_bits_.assign(num_block_ + 1, 0);
+    tables.block_tuples_.assign(num_block_ + 1, 0);
+    size_t pos = 0;
+    for (uint32_t i = 0; i < num_block_; ++i) {
+      tables.block_bits_[i + 1] = tables.block_bits_[i] + PopVarint(&pos);
+      tables.block_tuples_[i + 1] = tables.block_tuples_[i] + static_cast<uint32_t>(PopVarint(&pos));
+    }
+    tables.BuildLookup();
+
+    byte_writer->AlignToByte();
+    while (byte_writer->Tellp() & 63) byte_writer->WriteByte(0);
+    uint64_t image_offset = byte_writer->Tellp() >> 3;
+    WriteLittleEndian(byte_writer, num_block_, 8);
+    WriteLittleEndian(byte_writer, tables.stride_, 8);
+    for (uint64_t bits : tables.block_bits_) WriteLittleEndian(byte_writer, bits, 8);
+    for (uint32_t tuples : tables.block_tuples_) WriteLittleEndian(byte_writer, tuples, 4);
+    if (tables.block_tuples_.size() & 1) WriteLittleEndian(byte_writer, 0, 4);
+    for (const EytzingerNode &node : tables.eytzinger_) {
+      WriteLittleEndian(byte_writer, node.first_tuple_, 4);
+      WriteLittleEndian(byte_writer, node.block_, 4);
+    }
+    return image_offset;
   }
 
  private:
-  // std::string index_file_ = std::to_string(getpid()) +  "_temp.index";
-  std::string index_file_ = "_temp.index";
-  std::unique_ptr<SequenceByteWriter> file_writer_;
+  // varint encoded (length, number of tuples) of each block
+  std::vector<unsigned char> entries_;
+  // varint encoded checkpoints of each block, see WriteCheckpoints()
+  std::vector<unsigned char> checkpoints_;
   uint32_t num_block_;
   uint32_t last_block_size_;
   int block_size_ = -1;
+
+  void PushVarint(uint64_t val) { PushVarint(&entries_, val); }
+
+  // same encoding as SequenceByteWriter::WriteVarint()
+  static void PushVarint(std::vector<unsigned char> *bytes, uint64_t val) {
+    for (; val >= 0x80; val >>= 7) bytes->push_back(static_cast<unsigned char>(val | 0x80));
+    bytes->push_back(static_cast<unsigned char>(val));
+  }
+
+  uint64_t PopVarint(size_t *pos) const {
+    uint64_t val = 0;
+    for (int shift = 0;; shift += 7) {
+      unsigned char byte = entries_[(*pos)++];
+      val |= static_cast<uint64_t>(byte & 0x7F) << shift;
+      if (!(byte & 0x80)) return val;
+    }
+  }
+
+  static void WriteLittleEndian(SequenceByteWriter *byte_writer, uint64_t val, int num_bytes) {
+    for (int i = 0; i < num_bytes; ++i, val >>= 8)
+      byte_writer->WriteByte(static_cast<unsigned char>(val));
+  }
 };
 
 /**
@@ -71,75 +250,275 @@ class IndexCreator {
  */
 class IndexReader {
  public:
-  explicit IndexReader() : file_reader_(index_file_), num_block_(0){};
-
   /**
-   * Init Indexer.
+   * Create an index reader.
+   *
+   * @param byte_reader reader of the compressed table
    */
-  void Init() {
-    file_reader_.Seekg(-4, 0, std::ios_base::end);
-    num_block_ = file_reader_.Read32Bit();
+  explicit IndexReader(const ByteReader &byte_reader) : file_reader_(byte_reader), num_block_(0){};
 
-    block_bits_.resize(num_block_ + 1, 0);
-    block_tuples_.resize(num_block_ + 1, 0);
+  // lookup tables may point into tables_
+  IndexReader(const IndexReader &) = delete;
+  IndexReader &operator=(const IndexReader &) = delete;
 
-    file_reader_.Seekg(-4 * num_block_ - 4, 0, std::ios_base::end);
+  /**
+   * Init Indexer. The index image is used in place if there is one and the
+   * machine is little endian, otherwise lookup tables are built from the index
+   * section.
+   *
+   * @param index_offset byte offset of the index section, it is recorded in the footer
+   * @param image_offset byte offset of the index image, 0 if there is none
+   */
+  void Init(uint64_t index_offset, uint64_t image_offset) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    if (image_offset != 0) {
+      const unsigned char *image = file_reader_.Data() + image_offset;
+      const auto *header = reinterpret_cast<const uint64_t *>(image);
+      if ((image_offset & 7) != 0 || image_offset + 16 > file_reader_.Size() ||
+          header[0] >= static_cast<uint64_t>(INT32_MAX) || header[1] > UINT32_MAX ||
+          image_offset + ImageSize(header[0], header[1]) > file_reader_.Size())
+        throw IOException("IndexReader::Init::Corrupted index image.\n");
+      num_block_ = static_cast<int>(header[0]);
+      stride_ = static_cast<uint32_t>(header[1]);
+      block_bits_ = header + 2;
+      block_tuples_ = reinterpret_cast<const uint32_t *>(block_bits_ + num_block_ + 1);
+      eytzinger_ = reinterpret_cast<const EytzingerNode *>(block_tuples_ + ((num_block_ + 2) & ~1));
+      eytzinger_size_ = stride_ > 0 ? 0 : num_block_ + 1;
+      PrintBlockSize();
+      return;
+    }
+#endif
+    file_reader_.Seekg(static_cast<int64_t>(index_offset), 0, std::ios_base::beg);
+    tables_.Read(&file_reader_);
+    num_block_ = static_cast<int>(tables_.block_tuples_.size()) - 1;
+    stride_ = tables_.stride_;
+    block_bits_ = tables_.block_bits_.data();
+    block_tuples_ = tables_.block_tuples_.data();
+    eytzinger_ = tables_.eytzinger_.data();
+    eytzinger_size_ = tables_.eytzinger_.size();
+    PrintBlockSize();
+  }
+
+  /**
+   * Load decoder checkpoints, see IndexCreator::WriteCheckpointSection(). It is
+   * called after Init().
+   *
+   * @param checkpoint_offset byte offset of the checkpoint section, it is recorded in the footer
+   */
+  void InitCheckpoints(uint64_t checkpoint_offset) {
+    file_reader_.Seekg(static_cast<int64_t>(checkpoint_offset), 0, std::ios_base::beg);
+    checkpoint_tuples_ = static_cast<uint32_t>(file_reader_.ReadVarint());
+    const int num_states = static_cast<int>(file_reader_.ReadVarint());
+    if (checkpoint_tuples_ == 0 || num_states <= 0 || num_states > kMaxInterleavedStates)
+      throw IOException("IndexReader::InitCheckpoints::Corrupted checkpoint section.\n");
+    block_checkpoints_.assign(num_block_ + 1, 0);
     for (int i = 0; i < num_block_; ++i) {
-      block_bits_[i + 1] = block_bits_[i] + file_reader_.Read16Bit();
-      block_tuples_[i + 1] = block_tuples_[i] + file_reader_.Read16Bit();
+      uint32_t num_checkpoints = static_cast<uint32_t>(file_reader_.ReadVarint());
+      block_checkpoints_[i + 1] = block_checkpoints_[i] + num_checkpoints;
+      for (uint32_t k = 0; k < num_checkpoints; ++k) {
+        DecoderCheckpoint checkpoint{};
+        checkpoint.interval_ = static_cast<uint32_t>(file_reader_.ReadVarint());
+        checkpoint.num_words_ = static_cast<uint32_t>(file_reader_.ReadVarint());
+        for (int j = 0; j < num_states; ++j) {
+          checkpoint.num_[j] = file_reader_.ReadVarint();
+          checkpoint.den_[j] = file_reader_.ReadVarint();
+          uint64_t virtual_words = file_reader_.ReadVarint();
+          checkpoint.virtual_bits_[j] = static_cast<uint32_t>(virtual_words >> 2);
+          checkpoint.num_virtual_[j] = static_cast<uint16_t>(virtual_words & 3);
+        }
+        checkpoints_.push_back(checkpoint);
+      }
     }
+  }
 
-    std::cout << "Block Size: " << block_tuples_[1] - block_tuples_[0] << " tuple" << std::endl;
+  /**
+   * Find the nearest checkpoint of block at or before a tuple.
+   *
+   * @param block_idx index of block
+   * @param offset index of tuple in block
+   * @return the k-th checkpoint of block, it is CheckpointTuples() * k tuples after the block
+   * start; or 0 if the tuple is decoded from the block start
+   */
+  inline uint32_t FindCheckpoint(int block_idx, uint32_t offset) const {
+    if (checkpoint_tuples_ == 0) return 0;
+    return std::min(offset / checkpoint_tuples_,
+                    block_checkpoints_[block_idx + 1] - block_checkpoints_[block_idx]);
   }
 
+  /**
+   * @param block_idx index of block
+   * @param checkpoint k for the k-th checkpoint of block, k > 0
+   * @return decoder state of checkpoint
+   */
+  const DecoderCheckpoint &Checkpoint(int block_idx, uint32_t checkpoint) const {
+    return checkpoints_[block_checkpoints_[block_idx] + checkpoint - 1];
+  }
+
+  /**
+   * @return number of tuples between checkpoints, 0 if there is none
+   */
+  uint32_t CheckpointTuples() const { return checkpoint_tuples_; }
+
   /**
    * Calculate the position of first bit to read, i.e. the first bit of block. Tuple index is
    * user-specified, it means where to start decompression. This function is used to support random
    * access.
    *
    * @param[out] n_byte how many bytes need to ignore (without decompression).
-   * @param[out] m_bit how many bits left to ignore
    * @param tuple_idx index of first block to be decompressed
    * @return return how many tuples we do not need, but have to decompress.csv.
    */
-  inline uint32_t LocateBlock(uint32_t &n_byte, size_t tuple_idx) {
-    block_idx_ = 0;
-    r_ = num_block_;
-    while (block_idx_ != r_) {
-      mid_ = block_idx_ + (r_ - block_idx_) / 2;
-      if (block_tuples_[mid_] <= tuple_idx && block_tuples_[mid_ + 1] > tuple_idx) {
-        block_idx_ = mid_;
-        r_ = mid_;
-      } else if (tuple_idx < block_tuples_[mid_])
-        r_ = mid_;
-      else
-        block_idx_ = mid_ + 1;
+  inline uint32_t LocateBlock(uint64_t &n_byte, size_t tuple_idx) {
+    uint32_t block_idx = FindBlock(tuple_idx);
+    n_byte = block_bits_[block_idx] << 1;
+    return tuple_idx - block_tuples_[block_idx];
+  }
+
+  /**
+   * Find the block of a tuple.
+   *
+   * @param tuple_idx index of tuple
+   * @return index of block
+   */
+  inline uint32_t FindBlock(size_t tuple_idx) const {
+    if (stride_ > 0) return static_cast<uint32_t>(tuple_idx / stride_);
+    // find the first node whose first tuple is larger than tuple_idx, its block follows the
+    // wanted one
+    size_t k = 1;
+    while (k < eytzinger_size_) {
+      __builtin_prefetch(eytzinger_ + k * kEytzingerNodesPerLine);
+      k = 2 * k + (eytzinger_[k].first_tuple_ <= tuple_idx);
     }
+    return LeafBlock(k);
+  }
 
-    n_byte = block_bits_[block_idx_] << 1;
-    return tuple_idx - block_tuples_[block_idx_];
+  /**
+   * Find the blocks of a batch of tuples. Up to kLookupGroupSize searches are in flight, each one
+   * requests its next node and gives way to the others instead of waiting for it, so that their
+   * cache misses overlap.
+   *
+   * @param tuple_ids indices of tuples
+   * @param num number of tuples
+   * @param[out] blocks blocks[i] is the block of tuple_ids[i]
+   */
+  void FindBlocks(const uint32_t *tuple_ids, size_t num, uint32_t *blocks) const {
+    if (stride_ > 0 || eytzinger_size_ <= 1) {
+      for (size_t i = 0; i < num; ++i) blocks[i] = FindBlock(tuple_ids[i]);
+      return;
+    }
+    size_t node[kLookupGroupSize], lookup[kLookupGroupSize];
+    size_t num_active = 0, next = 0;
+    for (; num_active < kLookupGroupSize && next < num; ++num_active, ++next) {
+      node[num_active] = 1;
+      lookup[num_active] = next;
+    }
+    while (num_active > 0) {
+      for (size_t i = 0; i < num_active;) {
+        size_t k = 2 * node[i] + (eytzinger_[node[i]].first_tuple_ <= tuple_ids[lookup[i]]);
+        if (k < eytzinger_size_) {
+          __builtin_prefetch(eytzinger_ + k);
+          node[i] = k;
+          ++i;
+          continue;
+        }
+        // the search is done, its slot takes the next tuple, or the last search if none is left
+        blocks[lookup[i]] = LeafBlock(k);
+        if (next < num) {
+          node[i] = 1;
+          lookup[i] = next++;
+          ++i;
+        } else {
+          --num_active;
+          node[i] = node[num_active];
+          lookup[i] = lookup[num_active];
+        }
+      }
+    }
   }
+
+  /**
+   * Request the index entries of a block, so that they are in cache when it is located.
+   *
+   * @param block_idx index of block
+   */
+  inline void PrefetchBlock(int block_idx) const {
+    __builtin_prefetch(block_bits_ + block_idx);
+    __builtin_prefetch(block_tuples_ + block_idx + 1);
+    if (checkpoint_tuples_ > 0) __builtin_prefetch(block_checkpoints_.data() + block_idx + 1);
+  }
+
   /**
    * Get the place of tuple, ONE BLOCK ONE TUPLE, here.
    *
    * @param tuple_idx
    * @return
    */
-  inline uint32_t LocateTuple(size_t tuple_idx) { return block_bits_[tuple_idx] << 1; }
+  inline uint64_t LocateTuple(size_t tuple_idx) { return block_bits_[tuple_idx] << 1; }
 
- private:
-  // std::string index_file_ = std::to_string(getpid()) +  "_temp.index";
-  std::string index_file_ = "_temp.index";
+  /**
+   * @return number of blocks
+   */
+  int NumBlocks() const { return num_block_; }
+
+  /**
+   * @param block_idx index of block
+   * @return how many bytes before the first bit of block
+   */
+  uint64_t BlockPosition(int block_idx) const { return block_bits_[block_idx] << 1; }
+
+  /**
+   * @param block_idx index of block
+   * @return index of the first tuple in block
+   */
+  uint32_t BlockFirstTuple(int block_idx) const { return block_tuples_[block_idx]; }
 
+ private:
   ByteReader file_reader_;
   int num_block_;
-  std::vector<uint32_t> block_bits_;
-  std::vector<unsigned> block_tuples_;
+  // tables built from the index section, unless the index image is used
+  BlockTables tables_;
+
+  // lookup tables, see BlockTables
+  const uint64_t *block_bits_ = nullptr;
+  const uint32_t *block_tuples_ = nullptr;
+  uint32_t stride_ = 0;
+  const EytzingerNode *eytzinger_ = nullptr;
+  size_t eytzinger_size_ = 0;
+  static constexpr size_t kEytzingerNodesPerLine = 64 / sizeof(EytzingerNode);
+  // decoder checkpoints, the ones of block i are [block_checkpoints_[i], block_checkpoints_[i + 1])
+  uint32_t checkpoint_tuples_ = 0;
+  std::vector<uint32_t> block_checkpoints_;
+  std::vector<DecoderCheckpoint> checkpoints_;
+
+  /**
+   * Finish a search of FindBlock(), i.e. the node past the leaves.
+   *
+   * @param k the node past the leaves
+   * @return index of block
+   */
+  inline uint32_t LeafBlock(size_t k) const {
+    k >>= __builtin_ffsll(~static_cast<long long>(k));
+    return (k == 0 ? num_block_ : eytzinger_[k].block_) - 1;
+  }
 
-  // binary search
-  uint32_t block_idx_;
-  uint32_t r_;
-  uint32_t mid_;
+  /**
+   * Bytes of an index image, see IndexCreator::WriteImage().
+   *
+   * @param num_block number of blocks
+   * @param stride stride of blocks, 0 if blocks are looked up in the search tree
+   * @return size of image in bytes
+   */
+  static uint64_t ImageSize(uint64_t num_block, uint64_t stride) {
+    uint64_t size = 16 + 8 * (num_block + 1) + 4 * ((num_block + 2) & ~static_cast<uint64_t>(1));
+    return stride > 0 ? size : size + sizeof(EytzingerNode) * (num_block + 1);
+  }
+
+  void PrintBlockSize() const {
+    if (stride_ > 0)
+      std::cout << "Block Size: " << stride_ << " tuple" << std::endl;
+    else
+      std::cout << "Block Size: variable, " << num_block_ << " blocks" << std::endl;
+  }
 };
 
 }  // namespace db_compress
@@ -48,6 +48,8 @@ class TableMarkov : public SquIDModel {
 
   void SetState(int state) { cur_state_ = state; };
 
+  void ResetState() override { cur_state_ = 0; }
+
  private:
   std::vector<TableCategorical> states_;
   int num_state_;
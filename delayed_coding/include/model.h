@@ -17,6 +17,7 @@
 namespace db_compress {
 
 class Decoder;
+class RansDecoder;
 
 /**
  * Decoder Class is initialized with two ProbIntervals and one SquID instance,
@@ -29,65 +30,192 @@ class Decoder {
  public:
   Decoder() = default;
 
+  /**
+   * Configure the delayed coding engine. Probability intervals of a block are
+   * spread round-robin across the states, i.e. the k-th interval of a block is
+   * decoded by state k % num_states. Independent states break the serial
+   * dependency chain of Update().
+   *
+   * @param config delayed coding engine, it must be valid
+   */
+  inline void Configure(const DelayedCodingConfig &config) {
+    state_mask_ = static_cast<uint16_t>(config.num_states_ - 1);
+    precision_ = static_cast<uint16_t>(config.precision_);
+    renorm_bits_ = static_cast<uint16_t>(config.renorm_bits_);
+    InitProbInterval();
+  }
+
   /**
    * Initialize probability interval as [0, 1]
    */
   inline void InitProbInterval() {
-    num_ = 0;
-    den_ = 1;
-    virtual_available_ = false;
+    for (int i = 0; i <= state_mask_; ++i) {
+      num_[i] = 0;
+      den_[i] = 1;
+      num_virtual_[i] = 0;
+    }
+    cur_ = 0;
     num_interval_ = 0;
   }
 
+  /**
+   * Resume decoding a block of the delayed coding backend at a checkpoint, the
+   * byte reader must be moved to the word recorded in it.
+   *
+   * @param checkpoint decoder state recorded by DelayedCoding()
+   */
+  inline void Restore(const DecoderCheckpoint &checkpoint) {
+    for (int i = 0; i <= state_mask_; ++i) {
+      num_[i] = checkpoint.num_[i];
+      den_[i] = checkpoint.den_[i];
+      num_virtual_[i] = checkpoint.num_virtual_[i];
+      virtual_bits_[i] = checkpoint.virtual_bits_[i];
+    }
+    cur_ = 0;
+    num_interval_ = checkpoint.interval_;
+  }
+
   /**
    * Return how many block has been decoded.
    *
    * @return current block index
    */
-  inline int CurBlockSize() const { return num_interval_; }
+  inline int CurBlockSize() const { return static_cast<int>(num_interval_); }
 
   /**
    * Update current probability interval with denominator and numerator by
    * numerator = numerator * denominator + numerator, denominator = denominator
-   * * denominator. Every time numerator > 2^48, two virtual bytes are
-   * generated.
+   * * denominator. Every time denominator >= 2^precision, the low renorm_bits
+   * of numerator are shifted out as virtual words. The state of the last
+   * Read16Bits() is updated.
    *
    * @param denominator denominator of input fraction
    * @param numerator numerator of input fraction
    */
   inline void Update(unsigned denominator, unsigned numerator) {
-    num_ = num_ * denominator + numerator;
-    den_ = den_ * denominator;
-
-    if ((den_ >> kDelayedCoding) > 0) {
-      virtual_available_ = true;
-      virtual_16bits_ = static_cast<uint16_t>(num_);
-      num_ >>= 16;
-      den_ >>= 16;
+    uint64_t num = num_[cur_] * denominator + numerator;
+    uint64_t den = den_[cur_] * denominator;
+
+    if ((den >> precision_) > 0) {
+      // the first virtual word is kept in the high 16 bits
+      num_virtual_[cur_] = static_cast<uint16_t>(renorm_bits_ >> 4);
+      virtual_bits_[cur_] = static_cast<uint32_t>(num << (32 - renorm_bits_));
+      num >>= renorm_bits_;
+      den >>= renorm_bits_;
     }
+    num_[cur_] = num;
+    den_[cur_] = den;
   }
 
   /**
-   * Read two bytes from virtual bytes buffer or disks. If virtual bytes buffer
-   * is not empty or has only one bytes, fetch two bytes from virtual bytes
-   * buffer, or read bytes from disks.
+   * Read two bytes from virtual bytes buffer or disks. If the state of current
+   * probability interval has virtual words, fetch the next one, or read bytes
+   * from disks.
    *
    * @param byte_reader byte reader is used to read bytes from disk
    * @return return two bytes.
    */
   inline unsigned Read16Bits(ByteReader *byte_reader) {
+    cur_ = num_interval_ & state_mask_;
+    ++num_interval_;
+    if (num_virtual_[cur_] == 0) return byte_reader->Read16BitFast();
+
+    --num_virtual_[cur_];
+    uint32_t bits = virtual_bits_[cur_];
+    virtual_bits_[cur_] = bits << 16;
+    return bits >> 16;
+  }
+
+ private:
+  uint64_t num_[kMaxInterleavedStates]{0}, den_[kMaxInterleavedStates]{1};
+  uint32_t virtual_bits_[kMaxInterleavedStates];
+  uint16_t num_virtual_[kMaxInterleavedStates]{0};
+  uint16_t state_mask_{0}, cur_{0};
+  uint16_t precision_{kDelayedCoding}, renorm_bits_{kRenormBits};
+  uint32_t num_interval_{0};
+};
+
+/**
+ * RansDecoder Class is the rANS counterpart of Decoder, it decodes the
+ * probability intervals emitted by RansCoding(). Squids are templated on the
+ * decoder, so the backend is chosen once per file rather than per symbol.
+ */
+class RansDecoder {
+ public:
+  RansDecoder() = default;
+
+  /**
+   * Configure the rANS engine, only the number of interleaved states is used.
+   * Probability intervals of a block are spread round-robin across the states.
+   *
+   * @param config rANS engine, it must be valid
+   */
+  inline void Configure(const DelayedCodingConfig &config) {
+    state_mask_ = static_cast<uint16_t>(config.num_states_ - 1);
+    InitProbInterval();
+  }
+
+  /**
+   * Start a new block, states are loaded from disk by the first probability
+   * interval each of them decodes.
+   */
+  inline void InitProbInterval() {
+    for (int i = 0; i <= state_mask_; ++i) state_[i] = kRansLowerBound;
+    cur_ = 0;
+    num_interval_ = 0;
+  }
+
+  /**
+   * Return how many block has been decoded.
+   *
+   * @return current block index
+   */
+  inline int CurBlockSize() const { return static_cast<int>(num_interval_); }
+
+  /**
+   * The state of the last Read16Bits() becomes state * denominator +
+   * numerator, where the 16 bits returned by Read16Bits() were already shifted
+   * out of the state. Thus, a probability interval of weight 1 needs no
+   * Update().
+   *
+   * @param denominator denominator of input fraction
+   * @param numerator numerator of input fraction
+   */
+  inline void Update(unsigned denominator, unsigned numerator) {
+    state_[cur_] = state_[cur_] * denominator + numerator;
+  }
+
+  /**
+   * Read two bytes from the state of the next probability interval. The state
+   * of the previous probability interval is renormalized first, so that words
+   * are read in the order RansCoding() emits them, no matter whether Update()
+   * was called.
+   *
+   * @param byte_reader byte reader is used to read bytes from disk
+   * @return the low 16 bits of the state
+   */
+  inline unsigned Read16Bits(ByteReader *byte_reader) {
+    if (state_[cur_] < kRansLowerBound) {
+      uint64_t high = byte_reader->Read16BitFast();
+      state_[cur_] = (state_[cur_] << 32) | (high << 16) | byte_reader->Read16BitFast();
+    }
+    cur_ = num_interval_ & state_mask_;
+    if (num_interval_ <= state_mask_) {
+      uint64_t state = 0;
+      for (int i = 0; i < 4; ++i) state = (state << 16) | byte_reader->Read16BitFast();
+      state_[cur_] = state;
+    }
     ++num_interval_;
-    if (!virtual_available_) return byte_reader->Read16BitFast();
 
-    virtual_available_ = false;
-    return virtual_16bits_;
+    uint64_t state = state_[cur_];
+    state_[cur_] = state >> 16;
+    return static_cast<unsigned>(state & 0xffff);
   }
 
  private:
-  uint64_t num_{0}, den_{1};
-  uint16_t virtual_16bits_;
-  bool virtual_available_{false};
-  uint16_t num_interval_{0};
+  uint64_t state_[kMaxInterleavedStates];
+  uint16_t state_mask_{0}, cur_{0};
+  uint32_t num_interval_{0};
 };
 
 /**
@@ -134,6 +262,13 @@ class SquIDModel {
    */
   virtual void EndOfData() {}
 
+  /**
+   * Reset state carried from one tuple to the next one, e.g. markov state or
+   * local dictionary. It is done at every block start, so that a block can be
+   * decoded on its own.
+   */
+  virtual void ResetState() {}
+
   /**
    * Get number of bits used to describe this model.
    *
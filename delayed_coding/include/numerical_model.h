@@ -143,11 +143,12 @@ class NumericalSquID {
    * saved by class member variable choice_. Notice that fast decoding is
    * only used in the first layer.
    *
-   * @param decoder it maintains the decompression process of delayed coding,
-   * some variables are saved here.
+   * @param decoder it maintains the decompression process of delayed coding
+   * or rANS, some variables are saved here.
    * @param byte_reader it reads bytes from compressed binary file
    */
-  void Decompress(Decoder *decoder, ByteReader *byte_reader);
+  template <class Engine>
+  void Decompress(Engine *decoder, ByteReader *byte_reader);
 
  private:
   double mean_, dev_;
@@ -199,9 +200,11 @@ class NumericalSquID {
                            int64_t idx);
 
   // decompression functions for histogram and exponential part
-  void HistogramDecompress(Decoder *decoder, ByteReader *byte_reader);
+  template <class Engine>
+  void HistogramDecompress(Engine *decoder, ByteReader *byte_reader);
 
-  void ExpDecompress(Decoder *decoder, ByteReader *byte_reader);
+  template <class Engine>
+  void ExpDecompress(Engine *decoder, ByteReader *byte_reader);
 };
 
 /**
@@ -26,7 +26,14 @@ class StringModel : public SquIDModel {
  public:
   StringSquID squid_;
 
-  explicit StringModel(size_t target_var);
+  /**
+   * Create a string model.
+   *
+   * @param target_var index of target attribute
+   * @param local_dict_size number of latest strings kept in local dictionary, 0
+   * disables local dictionary. It is recorded in the model description.
+   */
+  explicit StringModel(size_t target_var, int local_dict_size = kLocalDictSize);
 
   StringSquID *GetSquID(const AttrVector &tuple);
 
@@ -40,6 +47,15 @@ class StringModel : public SquIDModel {
 
   static StringModel *ReadModel(ByteReader *byte_reader, size_t index);
 
+  void ResetState() override { squid_.ResetLocalDict(); }
+
+  /**
+   * Get local dictionary size. If it is not zero, string values depend on former tuples.
+   *
+   * @return local dictionary size
+   */
+  int GetLocalDictSize() const { return local_dict_size_; }
+
  private:
   // How many words in the given sentence.
   TableCategorical num_words_squid_;
@@ -58,6 +74,7 @@ class StringModel : public SquIDModel {
   GlobalDictionary global_dictionary_;
 
   // local dictionary
+  int local_dict_size_;
   std::deque<std::string> local_dict_;
   TableCategorical dict_idx_;
   TableCategorical delta_encoding_;
@@ -73,9 +90,18 @@ class StringModel : public SquIDModel {
 
 class StringModelCreator : public ModelCreator {
  public:
+  /**
+   * @param local_dict_size local dictionary size of created string models
+   */
+  explicit StringModelCreator(int local_dict_size = kLocalDictSize)
+      : local_dict_size_(local_dict_size) {}
+
   SquIDModel *ReadModel(ByteReader *byte_reader, const Schema &schema, size_t index) override;
   SquIDModel *CreateModel(const std::vector<int> &attr_type, const std::vector<size_t> &predictor,
                           size_t index, double err) override;
+
+ private:
+  int local_dict_size_;
 };
 
 }  // namespace db_compress
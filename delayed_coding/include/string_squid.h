@@ -6,6 +6,7 @@
 #ifndef DB_COMPRESS_STRING_SQUID_H
 #define DB_COMPRESS_STRING_SQUID_H
 
+#include <algorithm>
 #include <deque>
 
 #include "base.h"
@@ -30,7 +31,8 @@ class MarkovCharDist {
   void GetMarkovProbInterval(std::vector<Branch *> &prob_intervals, int &prob_intervals_index,
                              const std::string &word);
 
-  void MarkovDecompress(Decoder *decoder, ByteReader *byte_reader, std::string &word,
+  template <class Engine>
+  void MarkovDecompress(Engine *decoder, ByteReader *byte_reader, std::string &word,
                         int word_length);
 
   /**
@@ -123,12 +125,19 @@ class StringSquID {
   void GetProbIntervals(std::vector<Branch *> &prob_intervals, int &prob_intervals_index,
                         const AttrValue &value);
 
-  void Decompress(Decoder *decoder, ByteReader *byte_reader);
+  template <class Engine>
+  void Decompress(Engine *decoder, ByteReader *byte_reader);
 
   void NormalCompress(std::vector<Branch *> &prob_intervals, int &prob_intervals_index,
                       const std::string &word);
 
-  std::string &NormalDecompress(Decoder *decoder, ByteReader *byte_reader);
+  template <class Engine>
+  std::string &NormalDecompress(Engine *decoder, ByteReader *byte_reader);
+
+  /**
+   * Empty the local dictionary, it keeps its size.
+   */
+  void ResetLocalDict() { std::fill(local_dict_.begin(), local_dict_.end(), std::string()); }
 
  private:
   AttrValue attr_;
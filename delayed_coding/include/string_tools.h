@@ -88,7 +88,8 @@ class GlobalDictionary {
 
   void EndOfData(TableCategorical &encoding_methods, StringSplitter &splitter);
 
-  std::string &Decompress(Decoder *decoder, ByteReader *byte_reader, bool &is_phrase);
+  template <class Engine>
+  std::string &Decompress(Engine *decoder, ByteReader *byte_reader, bool &is_phrase);
 
   void GetProbIntervals(std::vector<Branch *> &prob_intervals, int &prob_intervals_index,
                         const std::string &word);
@@ -192,7 +192,7 @@ struct BitString {
 
   inline void Finish(SequenceByteWriter *byte_writer) {
     assert(num_ < size_);
-    for (size_t i = size_ - num_; i < size_; ++i) byte_writer->Write16Bit(bits_[i]);
+    byte_writer->WriteWords(bits_.data() + size_ - num_, num_);
   }
 };
 
@@ -210,19 +210,41 @@ struct BitString {
  */
 void InitDelayedCodingParams(std::vector<unsigned int> &weights, DelayedCodingParams &params);
 /**
- * Delayed Coding.
+ * Delayed Coding. Probability intervals are spread round-robin across
+ * interleaved states, which are coded separately; the words of all states are
+ * emitted in interval order.
  *
  * @param prob_intervals probability intervals generated from real dataset
  * @param interval_size size of probability intervals, it is used to avoid
  * push_back of vector
  * @param[out] bit_string encoded bits are saved here
- * @param virtual_byte_vector helper variables, it is used to avoid memory
+ * @param sym_is_virtual helper variables, it is used to avoid memory
  * allocation per calling
- * @param bytes_string helper variables, it is used to avoid memory allocation
- * per calling
+ * @param config delayed coding engine
+ * @param checkpoint_intervals optional, ascending indices of probability intervals in (0,
+ * interval_size), the decoder state right before each of them is recorded
+ * @param[out] checkpoints decoder states of checkpoint_intervals
  */
 void DelayedCoding(const std::vector<Branch *> &prob_intervals, int &interval_size,
-                   BitString *bit_string, std::vector<bool> &sym_is_virtual);
+                   BitString *bit_string, std::vector<bool> &sym_is_virtual,
+                   const DelayedCodingConfig &config = DelayedCodingConfig(),
+                   const std::vector<int> *checkpoint_intervals = nullptr,
+                   std::vector<DecoderCheckpoint> *checkpoints = nullptr);
+/**
+ * Interleaved rANS coding. It consumes the same probability intervals as
+ * DelayedCoding(): a probability interval of weight w takes the 16-bit word
+ * Embed(state % w), and the state becomes state / w. Probability intervals are
+ * spread round-robin across states like DelayedCoding(), every state is
+ * renormalized by 32 bits, and its final 64 bits are emitted in front of its
+ * first probability interval.
+ *
+ * @param prob_intervals probability intervals generated from real dataset
+ * @param interval_size size of probability intervals
+ * @param[out] bit_string encoded bits are saved here
+ * @param config coding engine, only the number of states is used
+ */
+void RansCoding(const std::vector<Branch *> &prob_intervals, int interval_size,
+                BitString *bit_string, const DelayedCodingConfig &config);
 /**
  * Estimate how many bits needed to encoding a probability interval with given
  * weight.
@@ -261,11 +283,47 @@ bool DoubleGreaterThan(double a, double b);
  */
 bool DoubleGreaterEqualThan(double a, double b);
 
-// This writes a vector of non-trivial data types.
-void Write(const std::vector<BiMap> &data);
+/**
+ * Write enum dictionaries into a compressed table.
+ *
+ * @param data enum values of each attribute, it is empty for non-categorical attributes
+ * @param byte_writer byte writer
+ */
+void WriteEnumDictionaries(const std::vector<BiMap> &data, SequenceByteWriter *byte_writer);
+
+/**
+ * Write branch weights of a statistic. Weights are varints, either all of them
+ * or only the non-zero ones, each with the number of zeros before it, whichever
+ * is shorter.
+ *
+ * @param weights branch weights
+ * @param byte_writer byte writer
+ */
+void WriteWeights(const std::vector<unsigned int> &weights, SequenceByteWriter *byte_writer);
 
-// This reads a vector of non-trivial data types.
-void Read(std::vector<BiMap> &data);
+/**
+ * Get the length of branch weights written by WriteWeights().
+ *
+ * @param weights branch weights
+ * @return number of bytes
+ */
+size_t GetWeightsLength(const std::vector<unsigned int> &weights);
+
+/**
+ * Read branch weights written by WriteWeights().
+ *
+ * @param byte_reader byte reader
+ * @param[in,out] weights it must be resized to the number of weights in advance
+ */
+void ReadWeights(ByteReader *byte_reader, std::vector<unsigned int> *weights);
+
+/**
+ * Read enum dictionaries written by WriteEnumDictionaries().
+ *
+ * @param byte_reader byte reader
+ * @param[out] data enum values of each attribute
+ */
+void ReadEnumDictionaries(ByteReader *byte_reader, std::vector<BiMap> *data);
 }  // namespace db_compress
 
 #endif
@@ -0,0 +1,79 @@
+#include "../include/block_cache.h"
+
+#include <string>
+#include <utility>
+#include <variant>
+
+namespace db_compress {
+namespace {
+// Approximate heap and inline bytes held by a decoded tuple.
+size_t TupleBytes(const AttrVector &tuple) {
+  size_t bytes = sizeof(AttrVector) + tuple.attr_.capacity() * sizeof(AttrValue);
+  for (const AttrValue &attr : tuple.attr_)
+    if (const auto *str = std::get_if<std::string>(&attr.value_)) bytes += str->capacity();
+  return bytes;
+}
+}  // anonymous namespace
+
+const AttrVector *BlockCache::Find(uint32_t start_tuple, uint32_t offset) {
+  auto it = positions_.find(start_tuple);
+  if (it == positions_.end() || entries_[it->second].tuples_.size() <= offset) {
+    stats_.misses_++;
+    return nullptr;
+  }
+  stats_.hits_++;
+  Entry &entry = entries_[it->second];
+  entry.referenced_ = true;
+  return &entry.tuples_[offset];
+}
+
+void BlockCache::Insert(uint32_t start_tuple, std::vector<AttrVector> &&tuples) {
+  size_t bytes = sizeof(Entry);
+  for (const AttrVector &tuple : tuples) bytes += TupleBytes(tuple);
+  if (bytes > capacity_bytes_) return;
+
+  auto it = positions_.find(start_tuple);
+  if (it != positions_.end()) {
+    Entry &entry = entries_[it->second];
+    if (entry.tuples_.size() >= tuples.size()) return;
+    // the longer prefix replaces the entry in place, it keeps its clock position
+    size_bytes_ -= entry.bytes_;
+    entry.bytes_ = 0;
+    MakeRoom(bytes);
+    it = positions_.find(start_tuple);
+    if (it != positions_.end()) {
+      Entry &kept = entries_[it->second];
+      kept.bytes_ = bytes;
+      kept.tuples_ = std::move(tuples);
+      size_bytes_ += bytes;
+      return;
+    }
+  } else {
+    MakeRoom(bytes);
+  }
+  positions_[start_tuple] = entries_.size();
+  entries_.push_back({start_tuple, false, bytes, std::move(tuples)});
+  size_bytes_ += bytes;
+}
+
+void BlockCache::MakeRoom(size_t bytes) {
+  while (size_bytes_ + bytes > capacity_bytes_ && !entries_.empty()) {
+    if (hand_ >= entries_.size()) hand_ = 0;
+    Entry &entry = entries_[hand_];
+    if (entry.referenced_) {
+      entry.referenced_ = false;
+      ++hand_;
+      continue;
+    }
+    // evict, the last entry takes over the slot and is examined next
+    size_bytes_ -= entry.bytes_;
+    positions_.erase(entry.start_tuple_);
+    if (hand_ + 1 < entries_.size()) {
+      entry = std::move(entries_.back());
+      positions_[entry.start_tuple_] = hand_;
+    }
+    entries_.pop_back();
+  }
+}
+
+}  // namespace db_compress
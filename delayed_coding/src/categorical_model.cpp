@@ -1,6 +1,8 @@
 #include "../include/categorical_model.h"
 
+#include <algorithm>
 #include <cmath>
+#include <map>
 #include <vector>
 
 #include "../include/base.h"
@@ -8,20 +10,51 @@
 #include "../include/utility.h"
 
 namespace db_compress {
-void CategoricalSquID::Decompress(Decoder *decoder, ByteReader *byte_reader) {
+namespace {
+/**
+ * Find the segment which a 16-bit word falls into.
+ *
+ * @param params delayed coding params
+ * @param two_bytes 16-bit word
+ * @param[out] branch branch of the segment
+ * @return segment index, i.e. the index of numerator helper
+ */
+unsigned LocateSegment(const DelayedCodingParams &params, unsigned two_bytes, int *branch) {
+  unsigned high_bits = two_bytes >> (16 - params.num_represent_bits_);
+  unsigned low_bits = two_bytes & ((1 << (16 - params.num_represent_bits_)) - 1);
+  bool flag = (low_bits < params.segment_left_branches_[high_bits].first);
+  *branch = flag ? params.segment_left_branches_[high_bits].second
+                 : params.segment_right_branches_[high_bits].second;
+  return (high_bits << 1) + static_cast<unsigned>(!flag);
+}
+}  // anonymous namespace
+
+template <class Engine>
+void CategoricalSquID::Decompress(Engine *decoder, ByteReader *byte_reader) {
   unsigned two_bytes = decoder->Read16Bits(byte_reader);
-  // P
-  unsigned high_bits = two_bytes >> (16 - coding_params_->num_represent_bits_);
-  // Q
-  unsigned low_bits = two_bytes & ((1 << (16 - coding_params_->num_represent_bits_)) - 1);
-  bool flag = (low_bits < (coding_params_->segment_left_branches_)[high_bits].first);
-  // character
-  choice_ = flag ? (coding_params_->segment_left_branches_)[high_bits].second
-                 : (coding_params_->segment_right_branches_)[high_bits].second;
-  // k
-  unsigned denominator = coding_params_->branches_[choice_].total_weights_;
-  unsigned index = (high_bits << 1) + static_cast<unsigned>(!flag);
-  unsigned numerator = two_bytes - coding_params_->numerator_helper_[index];
+  unsigned denominator;
+  unsigned numerator;
+
+  const CategoricalDecodeEntry *entry =
+      decode_table_ == nullptr ? nullptr : &decode_table_[two_bytes >> decode_table_shift_];
+  if (entry != nullptr && !entry->split_) {
+    choice_ = entry->branch_;
+    denominator = entry->denominator_minus_one_ + 1;
+    numerator = two_bytes - entry->numerator_offset_;
+  } else {
+    // P
+    unsigned high_bits = two_bytes >> (16 - coding_params_->num_represent_bits_);
+    // Q
+    unsigned low_bits = two_bytes & ((1 << (16 - coding_params_->num_represent_bits_)) - 1);
+    bool flag = (low_bits < (coding_params_->segment_left_branches_)[high_bits].first);
+    // character
+    choice_ = flag ? (coding_params_->segment_left_branches_)[high_bits].second
+                   : (coding_params_->segment_right_branches_)[high_bits].second;
+    // k
+    denominator = coding_params_->branches_[choice_].total_weights_;
+    unsigned index = (high_bits << 1) + static_cast<unsigned>(!flag);
+    numerator = two_bytes - coding_params_->numerator_helper_[index];
+  }
   decoder->Update(denominator, numerator);
 
   // if we come across a rare branch
@@ -34,6 +67,9 @@ void CategoricalSquID::Decompress(Decoder *decoder, ByteReader *byte_reader) {
     decoder->Update(denominator, numerator);
   }
 }
+
+template void CategoricalSquID::Decompress(Decoder *decoder, ByteReader *byte_reader);
+template void CategoricalSquID::Decompress(RansDecoder *decoder, ByteReader *byte_reader);
 void CategoricalSquID::GetProbIntervals(std::vector<Branch *> &prob_intervals,
                                         int &prob_intervals_index, const AttrValue &value) const {
   //  if (prob_intervals_index + 2 >= prob_intervals.size()) {
@@ -159,6 +195,7 @@ void TableCategorical::EndOfData() {
       stats.weight_[index_max_weight] += left_weight;
 
     InitDelayedCodingParams(stats.weight_, stats.coding_params_);
+    stats.InitDecodeTable();
 
     // update model cost
     for (size_t j = 0; j < counts.size(); j++) {
@@ -176,7 +213,9 @@ void TableCategorical::EndOfData() {
 int TableCategorical::GetModelDescriptionLength() const {
   size_t table_size = dynamic_list_.Size();
   // See WriteModel function for details of model description.
-  return static_cast<int>(table_size * (target_range_ - 1) * 16 + predictor_list_size_ * 16 + 32);
+  size_t length = 0;
+  for (size_t i = 0; i < table_size; ++i) length += 1 + GetWeightsLength(dynamic_list_[i].weight_);
+  return static_cast<int>(length * 8 + predictor_list_size_ * 16 + 24);
 }
 
 void TableCategorical::WriteModel(SequenceByteWriter *byte_writer) {
@@ -185,17 +224,18 @@ void TableCategorical::WriteModel(SequenceByteWriter *byte_writer) {
   for (size_t i = 0; i < predictor_list_size_; ++i) byte_writer->Write16Bit(predictor_list_[i]);
   byte_writer->Write16Bit(target_range_);
 
-  // Write Model Parameters
+  // Write Model Parameters. A cell with the same weights as an earlier cell is written as the
+  // index of that cell plus one, otherwise 0 is followed by its weights.
   size_t table_size = dynamic_list_.Size();
-  for (int i = 0; i < static_cast<int>(table_size); ++i) {
-    std::vector<unsigned> weights = dynamic_list_[i].weight_;
-    for (size_t j = 0; j < weights.size(); ++j) {
-      // 65536 cannot be represented by 16 bits. Once there is a 65536 weight branch, then all left
-      // weights are zero. So, we use 65535 to represent 65536.
-      if (weights[j] == 65536)
-        byte_writer->Write16Bit(65535);
-      else
-        byte_writer->Write16Bit(weights[j]);
+  std::map<std::vector<unsigned>, size_t> written;
+  for (size_t i = 0; i < table_size; ++i) {
+    const std::vector<unsigned> &weights = dynamic_list_[i].weight_;
+    auto it = written.emplace(weights, i);
+    if (!it.second) {
+      byte_writer->WriteVarint(it.first->second + 1);
+    } else {
+      byte_writer->WriteVarint(0);
+      WriteWeights(weights, byte_writer);
     }
   }
 }
@@ -216,25 +256,21 @@ TableCategorical *TableCategorical::ReadModel(ByteReader *byte_reader, const Sch
 
   // Read Model Parameters
   size_t table_size = model->dynamic_list_.Size();
-  for (int i = 0; i < static_cast<int>(table_size); ++i) {
+  for (size_t i = 0; i < table_size; ++i) {
     CategoricalStats &stats = model->dynamic_list_[i];
-    stats.weight_.resize(target_range + 1);
+    // a cell equal to an earlier one is copied, delayed coding params included
+    size_t same_cell = byte_reader->ReadVarint();
+    if (same_cell > 0) {
+      stats = model->dynamic_list_[same_cell - 1];
+      continue;
+    }
 
     // Read weights
-    size_t only_value = -1;
-    unsigned sum_weights = 0;
-    for (size_t j = 0; j < stats.weight_.size(); ++j) {
-      stats.weight_[j] = byte_reader->Read16Bit();
-      sum_weights += stats.weight_[j];
-
-      // label branch of weight 65535, there could be only one 65535 weight branch.
-      if (stats.weight_[j] == 65535) only_value = j;
-    }
-    // If sum of weights is not 65536, it means ''only value'' exists.
-    if (sum_weights != 65536) {
-      stats.weight_[only_value] = 65536;
-      stats.only_value_ = only_value;
-    }
+    stats.weight_.resize(target_range + 1);
+    ReadWeights(byte_reader, &stats.weight_);
+    // a branch of weight 65536 is the ''only value''
+    for (size_t j = 0; j < stats.weight_.size(); ++j)
+      if (stats.weight_[j] == 65536) stats.only_value_ = j;
 
     // init rare branch handler
     if (stats.weight_[stats.weight_.size() - 1] != 0 &&
@@ -243,6 +279,7 @@ TableCategorical *TableCategorical::ReadModel(ByteReader *byte_reader, const Sch
 
     // Preparation for delayed coding
     InitDelayedCodingParams(stats.weight_, stats.coding_params_);
+    stats.InitDecodeTable();
   }
 
   model->base_squid_.Init(model->dynamic_list_[0]);
@@ -273,6 +310,35 @@ SquIDModel *TableCategoricalCreator::CreateModel(const std::vector<int> &attr_ty
   return new TableCategorical(attr_type, predictor, index);
 }
 
+void CategoricalStats::InitDecodeTable() {
+  decode_table_.clear();
+  decode_table_shift_ = 16;
+  // branch index must fit in 16 bits
+  if (coding_params_.segment_left_branches_.empty() || coding_params_.branches_.size() > 65536)
+    return;
+
+  int table_bits = std::min(coding_params_.num_represent_bits_ + kDecodeTableExtraBits,
+                            kDecodeTableMaxBits);
+  decode_table_shift_ = 16 - table_bits;
+  decode_table_.resize(1 << table_bits);
+
+  // An entry covers words [first, last]. Segments are contiguous, so the entry
+  // is not split iff the first and last word fall into the same segment.
+  for (unsigned i = 0; i < decode_table_.size(); ++i) {
+    unsigned first = i << decode_table_shift_;
+    unsigned last = first + (1 << decode_table_shift_) - 1;
+    int first_branch, last_branch;
+    unsigned first_index = LocateSegment(coding_params_, first, &first_branch);
+    unsigned last_index = LocateSegment(coding_params_, last, &last_branch);
+
+    CategoricalDecodeEntry &entry = decode_table_[i];
+    entry.split_ = (first_index != last_index);
+    entry.branch_ = first_branch;
+    entry.denominator_minus_one_ = coding_params_.branches_[first_branch].total_weights_ - 1;
+    entry.numerator_offset_ = coding_params_.numerator_helper_[first_index];
+  }
+}
+
 void ZeroBranchHandler::Init(std::vector<unsigned int> weights) {
   for (unsigned weight : weights)
     if (weight == 0) map_size_++;
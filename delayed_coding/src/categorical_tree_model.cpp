@@ -24,7 +24,8 @@ void db_compress::CategoricalTreeSquid::GetProbIntervals(
                                             AttrValue(term_id));
 }
 
-void db_compress::CategoricalTreeSquid::Decompress(db_compress::Decoder *decoder,
+template <class Engine>
+void db_compress::CategoricalTreeSquid::Decompress(Engine *decoder,
                                                    db_compress::ByteReader *byte_reader) {
   group_table_squid_->Decompress(decoder, byte_reader);
   int group_id = group_table_squid_->GetResultAttr().Int();
@@ -33,6 +34,11 @@ void db_compress::CategoricalTreeSquid::Decompress(db_compress::Decoder *decoder
   attr_.value_ = ((group_id << group_size_bits_) + term_id);
 }
 
+template void db_compress::CategoricalTreeSquid::Decompress(db_compress::Decoder *decoder,
+                                                            db_compress::ByteReader *byte_reader);
+template void db_compress::CategoricalTreeSquid::Decompress(db_compress::RansDecoder *decoder,
+                                                            db_compress::ByteReader *byte_reader);
+
 void db_compress::TableCategoricalTree::FeedAttrs(const db_compress::AttrValue &attr_val,
                                                   int count) {
   int value = attr_val.Int();
@@ -1,6 +1,9 @@
 #include "compression.h"
 
+#include <condition_variable>
 #include <memory>
+#include <mutex>
+#include <thread>
 
 #include "base.h"
 #include "blitzcrank_exception.h"
@@ -14,18 +17,80 @@
 #include "utility.h"
 
 namespace db_compress {
+namespace {
+// The squid is pre-bound to the step.
+template <class SquID>
+void EncodeBound(const TupleEncodeStep &step, const AttrVector &tuple,
+                 std::vector<Branch *> &prob_intervals, int &prob_intervals_index) {
+  static_cast<SquID *>(step.squid_)
+      ->GetProbIntervals(prob_intervals, prob_intervals_index, tuple.attr_[step.target_var_]);
+}
+
+// The squid depends on the values of predictors.
+template <class Model, class SquID>
+void EncodeWithPredictors(const TupleEncodeStep &step, const AttrVector &tuple,
+                          std::vector<Branch *> &prob_intervals, int &prob_intervals_index) {
+  SquID *squid = static_cast<Model *>(step.model_)->GetSquID(tuple);
+  squid->GetProbIntervals(prob_intervals, prob_intervals_index, tuple.attr_[step.target_var_]);
+}
+
+void EncodeMarkov(const TupleEncodeStep &step, const AttrVector &tuple,
+                  std::vector<Branch *> &prob_intervals, int &prob_intervals_index) {
+  auto *model = static_cast<TableMarkov *>(step.model_);
+  CategoricalSquID *squid = model->GetSquID(tuple);
+  squid->GetProbIntervals(prob_intervals, prob_intervals_index, tuple.attr_[step.target_var_]);
+  model->SetState(tuple.attr_[step.target_var_].Int());
+}
+
+// Entropy code a block with the backend of the file, checkpoints are recorded by delayed coding.
+void EncodeBlock(const std::vector<Branch *> &prob_intervals, int &interval_size,
+                 BitString *bit_string, std::vector<bool> &is_virtual,
+                 const DelayedCodingConfig &config, const std::vector<int> &checkpoint_intervals,
+                 std::vector<DecoderCheckpoint> *checkpoints) {
+  if (config.backend_ == kRansBackend)
+    RansCoding(prob_intervals, interval_size, bit_string, config);
+  else
+    DelayedCoding(prob_intervals, interval_size, bit_string, is_virtual, config,
+                  &checkpoint_intervals, checkpoints);
+}
+
+// Models with cross-tuple state, i.e. markov models and strings with a local dictionary. It is
+// reset at block starts only, so such models cannot resume at a checkpoint.
+bool HasCrossTupleState(const Schema &schema, const std::vector<std::unique_ptr<SquIDModel>> &models) {
+  for (size_t i = 0; i < schema.attr_type_.size(); ++i) {
+    if (schema.attr_type_[i] == 5) return true;
+    if (schema.attr_type_[i] == 3 &&
+        static_cast<const StringModel *>(models[i].get())->GetLocalDictSize() > 0)
+      return true;
+  }
+  return false;
+}
+}  // anonymous namespace
+
 void RelationCompressor::WriteProbInterval() {
-  DelayedCoding(prob_intervals_, prob_intervals_index_, &bit_string_, is_virtual_);
+  EncodeBlock(prob_intervals_, prob_intervals_index_, &bit_string_, is_virtual_, coding_config_,
+              checkpoint_intervals_, &checkpoints_);
   bit_string_.Finish(byte_writer_.get());
   index_creator_.WriteBlockInfo(bit_string_.num_, num_tuples_);
+  if (checkpoint_tuples_ > 0) index_creator_.WriteCheckpoints(checkpoints_, coding_config_.num_states_);
+  ResetBlock();
+}
+
+void RelationCompressor::ResetBlock() {
+  for (auto &model : model_) model->ResetState();
   prob_intervals_index_ = 0;
+  num_block_tuples_ = 0;
+  checkpoint_intervals_.clear();
+  checkpoints_.clear();
 }
 
 RelationCompressor::RelationCompressor(const char *output_file, const Schema &schema,
-                                       const CompressionConfig &config, const int block_size)
+                                       const CompressionConfig &config, const int block_size,
+                                       const DelayedCodingConfig &coding_config)
     : output_file_(output_file),
       schema_(schema),
       kBlockSizeThreshold_(block_size),
+      coding_config_(coding_config),
       learner_(new RelationModelLearner(schema, config)),
       bit_string_((block_size << 8) + kIntervalSize),
       num_tuples_(0),
@@ -33,6 +98,21 @@ RelationCompressor::RelationCompressor(const char *output_file, const Schema &sc
       prob_intervals_index_(0) {
   prob_intervals_.resize((block_size << 8) + kIntervalSize);
   is_virtual_.resize((block_size << 8) + kIntervalSize);
+  if (!coding_config.IsValid())
+    throw BlitzcrankException(
+        "RelationCompressor::Unsupported delayed coding engine. Backend: " +
+        std::to_string(coding_config.backend_) + "\tStates: " +
+        std::to_string(coding_config.num_states_) + "\tPrecision: " +
+        std::to_string(coding_config.precision_) + "\tRenormalization Bits: " +
+        std::to_string(coding_config.renorm_bits_) + "\tCheckpoint: " +
+        std::to_string(coding_config.checkpoint_tuples_) + "\n");
+}
+
+RelationCompressor::RelationCompressor(std::vector<unsigned char> *output, const Schema &schema,
+                                       const CompressionConfig &config, int block_size,
+                                       const DelayedCodingConfig &coding_config)
+    : RelationCompressor("", schema, config, block_size, coding_config) {
+  sink_ = output;
 }
 
 void RelationCompressor::EndOfLearning() {
@@ -46,18 +126,39 @@ void RelationCompressor::EndOfLearning() {
     }
     attr_order_ = learner_->GetOrderOfAttributes();
     learner_ = nullptr;
+    BuildPlan();
+    if (!HasCrossTupleState(schema_, model_)) checkpoint_tuples_ = coding_config_.checkpoint_tuples_;
 
     // Initialize Compressed File
-    byte_writer_ = std::make_unique<SequenceByteWriter>(output_file_);
+    if (sink_ != nullptr) {
+      sink_->clear();
+      byte_writer_ = std::make_unique<SequenceByteWriter>(sink_);
+    } else {
+      byte_writer_ = std::make_unique<SequenceByteWriter>(output_file_);
+    }
     byte_writer_->ClearNumBits();
-    // Write Models
+    // Container header, see ReadCodecId()
+    byte_writer_->Write32Bit(kContainerMagic);
+    byte_writer_->Write16Bit(kContainerVersion);
+    byte_writer_->Write16Bit(coding_config_.backend_);
     // Randomly sampled tuples should not be counted.
     byte_writer_->Write32Bit(num_tuples_ - kNumEstSample);
-    for (uint64_t attr : attr_order_) byte_writer_->Write16Bit(attr);
+    // Write delayed coding params
+    byte_writer_->Write32Bit(kBlockSizeThreshold_);
+    byte_writer_->Write16Bit(coding_config_.num_states_);
+    byte_writer_->Write16Bit(coding_config_.precision_);
+    byte_writer_->Write16Bit(coding_config_.renorm_bits_);
 
+    // Model section
+    model_offset_ = byte_writer_->Tellp() >> 3;
+    for (uint64_t attr : attr_order_) byte_writer_->Write16Bit(attr);
     for (size_t i = 0; i < schema_.attr_type_.size(); ++i)
       model_[i]->WriteModel(byte_writer_.get());
     uint64_t num_bits = byte_writer_->GetNumBits();
+
+    // Data section
+    byte_writer_->AlignToByte();
+    data_offset_ = byte_writer_->Tellp() >> 3;
     // stats
     std::cout << "Model Size: " << (num_bits / double(1 << 13)) << " KB. \n";
   }
@@ -65,68 +166,193 @@ void RelationCompressor::EndOfLearning() {
   // round.
   num_tuples_ = 0;
 
-  // reset markov
-  for (size_t attr_index : attr_order_) {
-    if (schema_.attr_type_[attr_index] == 5) {
-      auto *model = static_cast<TableMarkov *>(model_[attr_index].get());
-      model->SetState(0);
-    }
-  }
+  for (auto &model : model_) model->ResetState();
 }
 
 void RelationCompressor::EndOfCompress() {
   compressor_stage_ = 2;
   // write down the last bitString even though bit_string_ is empty
   WriteProbInterval();
+
+  // Enum section
+  byte_writer_->AlignToByte();
+  uint64_t enum_offset = byte_writer_->Tellp() >> 3;
+  WriteEnumDictionaries(enum_dicts_, byte_writer_.get());
+  // Index section
+  byte_writer_->AlignToByte();
+  uint64_t index_offset = byte_writer_->Tellp() >> 3;
+  index_creator_.End(byte_writer_.get());
+  // Index image
+  uint64_t image_offset = 0;
+  if (coding_config_.index_image_) image_offset = index_creator_.WriteImage(byte_writer_.get());
+  // Checkpoint section
+  uint64_t checkpoint_offset = 0;
+  if (checkpoint_tuples_ > 0)
+    checkpoint_offset = index_creator_.WriteCheckpointSection(
+        byte_writer_.get(), checkpoint_tuples_, coding_config_.num_states_);
+  // Footer
+  byte_writer_->WriteUint64(model_offset_);
+  byte_writer_->WriteUint64(data_offset_);
+  byte_writer_->WriteUint64(enum_offset);
+  byte_writer_->WriteUint64(index_offset);
+  byte_writer_->WriteUint64(image_offset);
+  byte_writer_->WriteUint64(checkpoint_offset);
+  byte_writer_->Write32Bit(kContainerMagic);
   byte_writer_ = nullptr;
-  index_creator_.End();
+  // a ByteReader over the output pads it, make room for that
+  if (sink_ != nullptr) sink_->reserve(sink_->size() + kMappedFilePadding);
 }
 
 void RelationCompressor::CompressTuple(AttrVector &tuple) {
+  ModelTuple(tuple);
+
+  // if there are enough probability intervals, write them down.
+  if (prob_intervals_index_ > kBlockSizeThreshold_) WriteProbInterval();
+}
+
+void RelationCompressor::WritePendingBlock(const PendingBlock &block) {
+  byte_writer_->WriteWords(block.bits_.data(), block.bits_.size());
+  index_creator_.WriteBlockInfo(block.bits_.size(), block.num_tuples_);
+  if (checkpoint_tuples_ > 0)
+    index_creator_.WriteCheckpoints(block.checkpoints_, coding_config_.num_states_);
+}
+
+void RelationCompressor::CompressTuples(std::vector<AttrVector>::iterator begin,
+                                        std::vector<AttrVector>::iterator end, int num_threads) {
+  if (num_threads <= 1) {
+    for (auto it = begin; it != end; ++it) CompressTuple(*it);
+    return;
+  }
+
+  // Blocks are sealed into a ring of slots. Block k lives in slot k % num_slots, so the writer
+  // has to flush block k before block k + num_slots can be sealed.
+  const size_t num_slots = 2 * num_threads;
+  std::vector<PendingBlock> slots(num_slots);
+  size_t num_sealed = 0, num_claimed = 0, num_written = 0;
+  bool no_more_blocks = false;
+  std::mutex mutex;
+  std::condition_variable block_sealed, block_encoded;
+
+  auto worker = [&]() {
+    BitString bit_string(prob_intervals_.size());
+    std::vector<bool> is_virtual(prob_intervals_.size());
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+      block_sealed.wait(lock, [&] { return num_claimed < num_sealed || no_more_blocks; });
+      if (num_claimed == num_sealed) return;
+      PendingBlock &block = slots[num_claimed++ % num_slots];
+      lock.unlock();
+
+      EncodeBlock(block.prob_intervals_, block.prob_intervals_index_, &bit_string, is_virtual,
+                  coding_config_, block.checkpoint_intervals_, &block.checkpoints_);
+      block.bits_.assign(bit_string.bits_.end() - bit_string.num_, bit_string.bits_.end());
+
+      lock.lock();
+      block.encoded_ = true;
+      block_encoded.notify_all();
+    }
+  };
+
+  // Flush the oldest sealed block, wait for its worker if necessary.
+  auto write_oldest = [&]() {
+    PendingBlock &block = slots[num_written % num_slots];
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      block_encoded.wait(lock, [&] { return block.encoded_; });
+    }
+    WritePendingBlock(block);
+    num_written++;
+  };
+
+  std::vector<std::thread> workers;
+  for (int i = 0; i < num_threads; ++i) workers.emplace_back(worker);
+  auto stop_workers = [&]() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      no_more_blocks = true;
+    }
+    block_sealed.notify_all();
+    for (std::thread &thread : workers) thread.join();
+  };
+
+  try {
+    for (auto it = begin; it != end; ++it) {
+      ModelTuple(*it);
+      if (prob_intervals_index_ <= kBlockSizeThreshold_) continue;
+
+      if (num_sealed - num_written == num_slots) write_oldest();
+      PendingBlock &block = slots[num_sealed % num_slots];
+      block.prob_intervals_.assign(prob_intervals_.begin(),
+                                   prob_intervals_.begin() + prob_intervals_index_);
+      block.prob_intervals_index_ = prob_intervals_index_;
+      block.num_tuples_ = num_tuples_;
+      block.checkpoint_intervals_ = checkpoint_intervals_;
+      block.encoded_ = false;
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        num_sealed++;
+      }
+      block_sealed.notify_one();
+      ResetBlock();
+    }
+    while (num_written < num_sealed) write_oldest();
+  } catch (...) {
+    stop_workers();
+    throw;
+  }
+  stop_workers();
+}
+
+void RelationCompressor::BuildPlan() {
+  plan_.clear();
   for (size_t attr_index : attr_order_) {
+    SquIDModel *model = model_[attr_index].get();
+    const bool bound = model->GetPredictorList().empty();
+    TupleEncodeStep step{nullptr, model, nullptr, model->GetTargetVar()};
     switch (schema_.attr_type_[attr_index]) {
       case 0: {
         // attribute types are recorded in schema, thus dynamic_cast is not
         // needed, and we are sure the static_cast result is correct.
-        auto *model = static_cast<TableCategorical *>(model_[attr_index].get());
-        CategoricalSquID *squid = model->GetSquID(tuple);
-        squid->GetProbIntervals(prob_intervals_, prob_intervals_index_,
-                                tuple.attr_[model->GetTargetVar()]);
-        break;
-      }
-      case 1: {
-        auto *model = static_cast<TableNumerical *>(model_[attr_index].get());
-        NumericalSquID *squid = model->GetSquID(tuple);
-        squid->GetProbIntervals(prob_intervals_, prob_intervals_index_,
-                                tuple.attr_[model->GetTargetVar()]);
+        if (bound) {
+          step.encode_ = EncodeBound<CategoricalSquID>;
+          step.squid_ = &static_cast<TableCategorical *>(model)->base_squid_;
+        } else {
+          step.encode_ = EncodeWithPredictors<TableCategorical, CategoricalSquID>;
+        }
         break;
       }
+      case 1:
       case 2: {
-        auto *model = static_cast<TableNumerical *>(model_[attr_index].get());
-        NumericalSquID *squid = model->GetSquID(tuple);
-        squid->GetProbIntervals(prob_intervals_, prob_intervals_index_,
-                                tuple.attr_[model->GetTargetVar()]);
+        if (bound) {
+          step.encode_ = EncodeBound<NumericalSquID>;
+          step.squid_ = &static_cast<TableNumerical *>(model)->base_squid_;
+        } else {
+          step.encode_ = EncodeWithPredictors<TableNumerical, NumericalSquID>;
+        }
         break;
       }
       case 3: {
-        auto *model = static_cast<StringModel *>(model_[attr_index].get());
-        StringSquID *squid = model->GetSquID(tuple);
-        squid->GetProbIntervals(prob_intervals_, prob_intervals_index_,
-                                tuple.attr_[model->GetTargetVar()]);
+        // string squid is initialized with statistics of every tuple.
+        step.encode_ = EncodeWithPredictors<StringModel, StringSquID>;
         break;
       }
       case 5: {
-        auto *model = static_cast<TableMarkov *>(model_[attr_index].get());
-        CategoricalSquID *squid = model->GetSquID(tuple);
-        squid->GetProbIntervals(prob_intervals_, prob_intervals_index_,
-                                tuple.attr_[model->GetTargetVar()]);
-        model->SetState(tuple.attr_[model->GetTargetVar()].Int());
+        step.encode_ = EncodeMarkov;
         break;
       }
       default:
         std::cerr << "Unsupported Data Attribute.\n";
+        continue;
     }
+    plan_.push_back(step);
   }
+}
+
+void RelationCompressor::ModelTuple(AttrVector &tuple) {
+  if (checkpoint_tuples_ > 0 && num_block_tuples_ > 0 && num_block_tuples_ % checkpoint_tuples_ == 0)
+    checkpoint_intervals_.push_back(prob_intervals_index_);
+  for (const TupleEncodeStep &step : plan_)
+    step.encode_(step, tuple, prob_intervals_, prob_intervals_index_);
   if (prob_intervals_index_ > prob_intervals_.size()) {
     throw BufferOverflowException(
         "Compressor::ReadNode::Need larger buffer or smaller block for "
@@ -136,18 +362,6 @@ void RelationCompressor::CompressTuple(AttrVector &tuple) {
   }
 
   num_tuples_++;
-
-  // if there are enough probability intervals, write them down.
-  if (prob_intervals_index_ > kBlockSizeThreshold_) {
-    WriteProbInterval();
-
-    // reset markov
-    //    for (size_t attr_index : attr_order_) {
-    //      if (schema_.attr_type_[attr_index] == 5) {
-    //        auto *model = static_cast<TableMarkov *>(model_[attr_index].get());
-    //        model->SetState(0);
-    //      }
-    //    }
-  }
+  num_block_tuples_++;
 }
 }  // namespace db_compress
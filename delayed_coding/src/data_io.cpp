@@ -1,6 +1,11 @@
 #include "../include/data_io.h"
 
-#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -10,46 +15,70 @@
 namespace db_compress {
 
 SequenceByteWriter::SequenceByteWriter(const std::string &file_name)
-    : file_(file_name, std::ios::binary), buffer_{0}, bits_counter_(0) {
+    : file_(file_name, std::ios::binary),
+      sink_(nullptr),
+      buffer_(kWriterBufferSize),
+      buffer_pos_(0),
+      acc_(0),
+      acc_bits_(0) {
   if (!file_) throw IOException("Cannot open file " + file_name + " for writing.\n");
 }
-// Write all the remaining, we can use bits_counter_ to determine the
-// size.
+
+SequenceByteWriter::SequenceByteWriter(std::vector<unsigned char> *sink)
+    : sink_(sink), buffer_(kWriterBufferSize), buffer_pos_(0), acc_(0), acc_bits_(0) {}
+// Write all the remaining, the last byte is padded with zeros.
 SequenceByteWriter::~SequenceByteWriter() {
-  file_.write(buffer_, (bits_counter_ >> 3) + static_cast<int>((bits_counter_ & 7) > 0));
+  AlignToByte();
+  DrainAccumulator();
+  FlushBuffer();
 }
-void SequenceByteWriter::WriteLess(unsigned char byte, size_t len) {
-  // stats
-  num_bits_ += len;
-
-  const int byte_index = bits_counter_ >> 3;
-  const int bits_index = bits_counter_ & 7;
-
-  if (len <= 8 - bits_index) {
-    buffer_[byte_index] += byte << (8 - len - bits_index);
-  } else {
-    buffer_[byte_index] += byte >> (len + bits_index - 8);
-    buffer_[byte_index + 1] += byte << (8 - (len + bits_index - 8));
-  }
-  bits_counter_ += len;
-
-  if (bits_counter_ >= (sizeof(buffer_) - 1) * 8) {
-    const int num_full_block = bits_counter_ >> 3;
-    file_.write(buffer_, num_full_block);
-    // the last block may be not full
-    const char last_byte = buffer_[num_full_block];
-    bits_counter_ &= 7;
-    std::fill_n(buffer_, sizeof(buffer_), 0);
-    buffer_[0] = last_byte;
+
+void SequenceByteWriter::DrainAccumulator() {
+  while (acc_bits_ >= 8) {
+    if (buffer_pos_ == buffer_.size()) FlushBuffer();
+    acc_bits_ -= 8;
+    buffer_[buffer_pos_++] = static_cast<char>(acc_ >> acc_bits_);
   }
+  acc_ &= (static_cast<uint64_t>(1) << acc_bits_) - 1;
 }
 
-void SequenceByteWriter::WriteByte(unsigned char byte) { WriteLess(byte, 8); }
+void SequenceByteWriter::FlushBuffer() {
+  if (sink_ != nullptr)
+    sink_->insert(sink_->end(), buffer_.begin(), buffer_.begin() + buffer_pos_);
+  else
+    file_.write(buffer_.data(), buffer_pos_);
+  flushed_bytes_ += buffer_pos_;
+  buffer_pos_ = 0;
+}
+
+void SequenceByteWriter::WriteLess(unsigned char byte, size_t len) { WriteBits(byte, len); }
+
+void SequenceByteWriter::WriteByte(unsigned char byte) { WriteBits(byte, 8); }
 
-void SequenceByteWriter::Write16Bit(unsigned int val) {
-  val &= 65535;
-  WriteByte(val >> 8);
-  WriteByte(val & 255);
+void SequenceByteWriter::Write16Bit(unsigned int val) { WriteBits(val, 16); }
+
+void SequenceByteWriter::WriteWords(const uint16_t *words, size_t num) {
+  if (acc_bits_ & 7) {
+    for (size_t i = 0; i < num; ++i) WriteBits(words[i], 16);
+    return;
+  }
+  num_bits_ += num << 4;
+  DrainAccumulator();
+  while (num > 0) {
+    size_t chunk = std::min(num, (buffer_.size() - buffer_pos_) >> 1);
+    if (chunk == 0) {
+      FlushBuffer();
+      continue;
+    }
+    char *out = buffer_.data() + buffer_pos_;
+    for (size_t i = 0; i < chunk; ++i) {
+      out[i << 1] = static_cast<char>(words[i] >> 8);
+      out[(i << 1) | 1] = static_cast<char>(words[i]);
+    }
+    buffer_pos_ += chunk << 1;
+    words += chunk;
+    num -= chunk;
+  }
 }
 
 void SequenceByteWriter::Write32Bit(unsigned char bytes[4]) {
@@ -58,10 +87,7 @@ void SequenceByteWriter::Write32Bit(unsigned char bytes[4]) {
   WriteByte(bytes[2]);
   WriteByte(bytes[3]);
 }
-void SequenceByteWriter::Write32Bit(uint32_t data) {
-  Write16Bit(data >> 16);
-  Write16Bit(data & 0xffff);
-}
+void SequenceByteWriter::Write32Bit(uint32_t data) { WriteBits(data, 32); }
 void SequenceByteWriter::WriteUint64(const uint64_t data) {
   unsigned high = data >> 32;
   unsigned low = data & 0xffffffff;
@@ -69,6 +95,85 @@ void SequenceByteWriter::WriteUint64(const uint64_t data) {
   Write32Bit(low);
 }
 
+MappedFile::MappedFile(const std::string &file_name, bool populate, MapAdvice advice)
+    : addr_(MAP_FAILED), length_(0) {
+  int fd = open(file_name.c_str(), O_RDONLY);
+  struct stat st {};
+  if (fd < 0 || fstat(fd, &st) != 0) {
+    if (fd >= 0) close(fd);
+    throw IOException("Cannot open file " + file_name + ".\n");
+  }
+  size_ = st.st_size;
+
+  // Reserve zero pages for the file and the padding, then map the file over
+  // the head of them.
+  const size_t page_size = sysconf(_SC_PAGESIZE);
+  length_ = (size_ + kMappedFilePadding + page_size - 1) / page_size * page_size;
+  addr_ = mmap(nullptr, length_, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (addr_ == MAP_FAILED) {
+    if (fd >= 0) close(fd);
+    throw IOException("Cannot reserve memory for file " + file_name + ".\n");
+  }
+  if (size_ > 0) {
+    int flags = MAP_PRIVATE | MAP_FIXED;
+#ifdef MAP_POPULATE
+    if (populate) flags |= MAP_POPULATE;
+#endif
+    if (mmap(addr_, size_, PROT_READ, flags, fd, 0) == MAP_FAILED) {
+      close(fd);
+      munmap(addr_, length_);
+      throw IOException("Cannot map file " + file_name + ".\n");
+    }
+  }
+  if (fd >= 0) close(fd);
+  data_ = static_cast<const unsigned char *>(addr_);
+  if (advice != MapAdvice::kNormal) Advise(0, size_, advice);
+}
+
+MappedFile::~MappedFile() { munmap(addr_, length_); }
+
+void ReadAhead::Refill(uint64_t pos) {
+  auto now = std::chrono::steady_clock::now();
+  auto micros = std::chrono::duration_cast<std::chrono::microseconds>(now - last_time_).count();
+  if (micros > 0 && pos > last_pos_) {
+    uint64_t window = (pos - last_pos_) * kReadAheadMicros / static_cast<uint64_t>(micros);
+    window_ = std::min<uint64_t>(std::max<uint64_t>(window, kReadAheadMinBytes), kReadAheadMaxBytes);
+  }
+  last_pos_ = pos;
+  last_time_ = now;
+
+  uint64_t begin = std::max(requested_, pos);
+  requested_ = std::min(end_, pos + window_);
+  if (begin < requested_) byte_reader_.Advise(begin, requested_ - begin, MapAdvice::kWillNeed);
+}
+
+void MappedFile::Advise(size_t offset, size_t length, MapAdvice advice) const {
+  const size_t page_size = sysconf(_SC_PAGESIZE);
+  size_t begin = (offset + page_size - 1) / page_size * page_size;
+  size_t end = std::min(offset + length, size_);
+  // a range reaching the end of the file covers its last page
+  if (end != size_) end = end / page_size * page_size;
+  if (begin >= end) return;
+  void *addr = static_cast<char *>(addr_) + begin;
+  switch (advice) {
+    case MapAdvice::kNormal:
+      madvise(addr, end - begin, MADV_NORMAL);
+      break;
+    case MapAdvice::kSequential:
+      madvise(addr, end - begin, MADV_SEQUENTIAL);
+      break;
+    case MapAdvice::kRandom:
+      madvise(addr, end - begin, MADV_RANDOM);
+      break;
+    case MapAdvice::kWillNeed:
+      madvise(addr, end - begin, MADV_WILLNEED);
+      break;
+    case MapAdvice::kDontNeed:
+      madvise(addr, end - begin, MADV_DONTNEED);
+      break;
+  }
+}
+
 // ByteReader::ByteReader(const std::string &file_name)
 //     : fin_(file_name, std::ios::binary), buffer_(0), buffer_len_(0) {
 //   if (!fin_) throw IOException("Cannot open file " + file_name + ".\n");
@@ -1,8 +1,12 @@
 #include "../include/decompression.h"
 
+#include <algorithm>
+#include <numeric>
+#include <thread>
 #include <utility>
 
 #include "base.h"
+#include "blitzcrank_exception.h"
 #include "timeseries_model.h"
 
 namespace db_compress {
@@ -10,91 +14,325 @@ namespace {
 SquIDModel *GetModelFromDescription(ByteReader *byte_reader, const Schema &schema, size_t index) {
   return GetAttrModel(schema.attr_type_[index])->ReadModel(byte_reader, schema, index);
 }
+
+inline const AttrValue &GetResult(CategoricalSquID *squid) { return squid->GetResultAttr(); }
+inline const AttrValue &GetResult(NumericalSquID *squid) { return squid->GetResultAttr(true); }
+inline const AttrValue &GetResult(StringSquID *squid) { return squid->GetResultAttr(); }
+
+// The squid is pre-bound to the step.
+template <class Engine, class SquID>
+void DecodeBound(const TupleDecodeStep<Engine> &step, Engine *decoder, ByteReader *byte_reader,
+                 AttrVector *tuple) {
+  auto *squid = static_cast<SquID *>(step.squid_);
+  squid->Decompress(decoder, byte_reader);
+  tuple->attr_[step.attr_index_] = GetResult(squid);
+}
+
+// The squid depends on the values of predictors.
+template <class Engine, class Model, class SquID>
+void DecodeWithPredictors(const TupleDecodeStep<Engine> &step, Engine *decoder,
+                          ByteReader *byte_reader, AttrVector *tuple) {
+  SquID *squid = static_cast<Model *>(step.model_)->GetSquID(*tuple);
+  squid->Decompress(decoder, byte_reader);
+  tuple->attr_[step.attr_index_] = GetResult(squid);
+}
+
+template <class Engine>
+void DecodeMarkov(const TupleDecodeStep<Engine> &step, Engine *decoder, ByteReader *byte_reader,
+                  AttrVector *tuple) {
+  auto *model = static_cast<TableMarkov *>(step.model_);
+  CategoricalSquID *squid = model->GetSquID(*tuple);
+  squid->Decompress(decoder, byte_reader);
+  tuple->attr_[step.attr_index_] = squid->GetResultAttr();
+  model->SetState(tuple->attr_[step.attr_index_].Int());
+}
 }  // anonymous namespace
 
 RelationDecompressor::RelationDecompressor(const char *compressed_file_name, Schema schema,
                                            int block_size)
-    : byte_reader_(compressed_file_name),
-      kBlockSizeThreshold(block_size),
-      schema_(std::move(schema)),
-      index_reader_(),
-      num_converted_tuples_(0) {}
+    : schema_(std::move(schema)),
+      num_converted_tuples_(0),
+      block_size_threshold_(block_size),
+      byte_reader_(compressed_file_name),
+      index_reader_(byte_reader_) {}
+
+RelationDecompressor::RelationDecompressor(std::vector<unsigned char> compressed, Schema schema,
+                                           int block_size)
+    : schema_(std::move(schema)),
+      num_converted_tuples_(0),
+      block_size_threshold_(block_size),
+      byte_reader_(std::move(compressed)),
+      index_reader_(byte_reader_) {}
 
 void RelationDecompressor::Init() {
+  // Container header
+  uint32_t magic = byte_reader_.Read32Bit();
+  unsigned version = byte_reader_.Read16Bit();
+  if (magic != kContainerMagic || version != kContainerVersion)
+    throw IOException("RelationDecompressor::Init::Unsupported container. Version: " +
+                      std::to_string(version) + "\n");
+  coding_config_.backend_ = byte_reader_.Read16Bit();
   // Number of tuples
   num_total_tuples_ = byte_reader_.Read32Bit();
+  // Delayed coding params
+  int block_size = static_cast<int>(byte_reader_.Read32Bit());
+  if (block_size != block_size_threshold_)
+    std::cout << "Block size " << block_size << " recorded in the file is used, instead of "
+              << block_size_threshold_ << ".\n";
+  block_size_threshold_ = block_size;
+  coding_config_.num_states_ = byte_reader_.Read16Bit();
+  coding_config_.precision_ = byte_reader_.Read16Bit();
+  coding_config_.renorm_bits_ = byte_reader_.Read16Bit();
+  if (!coding_config_.IsValid())
+    throw IOException("RelationDecompressor::Init::Unsupported delayed coding engine. Backend: " +
+                      std::to_string(coding_config_.backend_) +
+                      "\tStates: " + std::to_string(coding_config_.num_states_) +
+                      "\tPrecision: " + std::to_string(coding_config_.precision_) +
+                      "\tRenormalization Bits: " + std::to_string(coding_config_.renorm_bits_) +
+                      "\n");
+  rans_ = coding_config_.backend_ == kRansBackend;
+  if (rans_)
+    rans_decoder_.Configure(coding_config_);
+  else
+    decoder_.Configure(coding_config_);
+
+  // Footer, i.e. offsets of sections
+  ByteReader footer(byte_reader_);
+  footer.Seekg(-kContainerFooterSize, 0, std::ios_base::end);
+  uint64_t model_offset = footer.ReadUint64();
+  uint64_t data_offset = footer.ReadUint64();
+  uint64_t enum_offset = footer.ReadUint64();
+  uint64_t index_offset = footer.ReadUint64();
+  uint64_t image_offset = footer.ReadUint64();
+  uint64_t checkpoint_offset = footer.ReadUint64();
+  if (footer.Read32Bit() != kContainerMagic)
+    throw IOException("RelationDecompressor::Init::Truncated compressed file.\n");
+
   // Ordering of attributes
+  byte_reader_.SetPos(model_offset << 3);
   for (size_t i = 0; i < schema_.attr_type_.size(); ++i) {
     attr_order_.push_back(byte_reader_.Read16Bit());
   }
   // Load models
-  model_.resize(schema_.attr_type_.size());
-  for (size_t i = 0; i < schema_.attr_type_.size(); ++i) {
-    std::unique_ptr<SquIDModel> model(GetModelFromDescription(&byte_reader_, schema_, i));
-    model_[i] = std::move(model);
-  }
+  model_pos_ = byte_reader_.Tellg();
+  ReadModels(&byte_reader_, &model_);
+  if (rans_)
+    BuildPlan(model_, &rans_plan_);
+  else
+    BuildPlan(model_, &plan_);
+  // Load enum dictionaries
+  ByteReader enum_reader(byte_reader_);
+  enum_reader.SetPos(enum_offset << 3);
+  ReadEnumDictionaries(&enum_reader, &enum_dicts_);
 
   // Default: decompress the whole data set
   num_todo_tuples_ = num_total_tuples_;
 
   // init index
-  index_reader_.Init();
-  data_pos_ = byte_reader_.Tellg();
+  index_reader_.Init(index_offset, image_offset);
+  if (checkpoint_offset != 0) index_reader_.InitCheckpoints(checkpoint_offset);
+  data_pos_ = data_offset << 3;
+  data_size_ = enum_offset - data_offset;
+  byte_reader_.SetPos(data_pos_);
+  read_ahead_ = std::make_unique<ReadAhead>(byte_reader_, data_offset, data_offset + data_size_);
+  read_ahead_->Advance(data_offset);
+}
+
+void RelationDecompressor::AdviseRandomAccess() {
+  if (random_access_) return;
+  byte_reader_.Advise(data_pos_ >> 3, data_size_, MapAdvice::kRandom);
+  random_access_ = true;
+  read_ahead_ = nullptr;
 }
+void RelationDecompressor::ReadModels(ByteReader *byte_reader,
+                                      std::vector<std::unique_ptr<SquIDModel> > *models) {
+  models->resize(schema_.attr_type_.size());
+  for (size_t i = 0; i < schema_.attr_type_.size(); ++i) {
+    std::unique_ptr<SquIDModel> model(GetModelFromDescription(byte_reader, schema_, i));
+    (*models)[i] = std::move(model);
+  }
+}
+
 void RelationDecompressor::LocateTuple(uint32_t tuple_idx) {
   assert(tuple_idx < num_total_tuples_);
-
-  num_todo_tuples_ = index_reader_.LocateBlock(num_bytes_, tuple_idx) + 1;
-  byte_reader_.SetPos(data_pos_ + (num_bytes_ << 3));
+  AdviseRandomAccess();
 
   tuple_idx_ = tuple_idx;
   num_converted_tuples_ = 0;
-  decoder_.InitProbInterval();
+  // decoding starts at the nearest checkpoint before the tuple, or at the block start
+  int block_idx = static_cast<int>(index_reader_.FindBlock(tuple_idx));
+  uint32_t offset = tuple_idx - index_reader_.BlockFirstTuple(block_idx);
+  uint32_t checkpoint = index_reader_.FindCheckpoint(block_idx, offset);
+  offset -= checkpoint * index_reader_.CheckpointTuples();
+  if (block_cache_ != nullptr) {
+    run_start_ = tuple_idx - offset;
+    cached_tuple_ = block_cache_->Find(run_start_, offset);
+    if (cached_tuple_ != nullptr) {
+      num_todo_tuples_ = 1;
+      return;
+    }
+    block_tuples_.clear();
+  }
+
+  num_todo_tuples_ = static_cast<int>(offset) + 1;
+  SeekBlock(block_idx, checkpoint);
 }
 
-void RelationDecompressor::ReadNextTuple(AttrVector *tuple) {
-  if (decoder_.CurBlockSize() > kBlockSizeThreshold) decoder_.InitProbInterval();
+void RelationDecompressor::SeekBlock(int block_idx, uint32_t checkpoint) {
+  num_bytes_ = index_reader_.BlockPosition(block_idx);
+  if (checkpoint == 0) {
+    byte_reader_.SetPos(data_pos_ + (num_bytes_ << 3));
+    InitBlock();
+    return;
+  }
+  // rANS files have no checkpoints
+  const DecoderCheckpoint &state = index_reader_.Checkpoint(block_idx, checkpoint);
+  byte_reader_.SetPos(data_pos_ + ((num_bytes_ + (static_cast<uint64_t>(state.num_words_) << 1)) << 3));
+  decoder_.Restore(state);
+}
 
-  for (int attr_index : attr_order_) {
-    switch (schema_.attr_type_[attr_index]) {
-      case 0: {
-        auto *model = static_cast<TableCategorical *>(model_[attr_index].get());
-        CategoricalSquID *squid = model->GetSquID(*tuple);
-        squid->Decompress(&decoder_, &byte_reader_);
-        tuple->attr_[attr_index] = squid->GetResultAttr();
-        break;
-      }
-      case 1: {
-        auto *model = static_cast<TableNumerical *>(model_[attr_index].get());
-        NumericalSquID *squid = model->GetSquID(*tuple);
-        squid->Decompress(&decoder_, &byte_reader_);
-        tuple->attr_[attr_index] = squid->GetResultAttr(true);
-        break;
-      }
-      case 2: {
-        auto *model = static_cast<TableNumerical *>(model_[attr_index].get());
-        NumericalSquID *squid = model->GetSquID(*tuple);
-        squid->Decompress(&decoder_, &byte_reader_);
-        tuple->attr_[attr_index] = squid->GetResultAttr(true);
-        break;
-      }
-      case 3: {
-        auto *model = static_cast<StringModel *>(model_[attr_index].get());
-        model->squid_.Decompress(&decoder_, &byte_reader_);
-        tuple->attr_[attr_index] = model->squid_.GetResultAttr();
-        break;
-      }
-      case 5: {
-        auto *model = static_cast<TableMarkov *>(model_[attr_index].get());
-        CategoricalSquID *squid = model->GetSquID(*tuple);
-        squid->Decompress(&decoder_, &byte_reader_);
-        tuple->attr_[attr_index] = squid->GetResultAttr();
-        model->SetState(tuple->attr_[attr_index].Int());
-        break;
+void RelationDecompressor::InitBlock() {
+  if (rans_)
+    rans_decoder_.InitProbInterval();
+  else
+    decoder_.InitProbInterval();
+  for (auto &model : model_) model->ResetState();
+}
+
+void RelationDecompressor::DecodeNext(AttrVector *tuple) {
+  if (rans_)
+    DecodeTuple(rans_plan_, &rans_decoder_, &byte_reader_, tuple);
+  else
+    DecodeTuple(plan_, &decoder_, &byte_reader_, tuple);
+}
+
+void RelationDecompressor::SetBlockCache(size_t capacity_bytes) {
+  block_cache_ = capacity_bytes > 0 ? std::make_unique<BlockCache>(capacity_bytes) : nullptr;
+  cached_tuple_ = nullptr;
+  block_tuples_.clear();
+}
+
+BlockCacheStats RelationDecompressor::GetBlockCacheStats() const {
+  return block_cache_ != nullptr ? block_cache_->Stats() : BlockCacheStats();
+}
+
+void RelationDecompressor::ReadTuples(const uint32_t *tuple_ids, size_t num, AttrVector *tuples) {
+  AdviseRandomAccess();
+  std::vector<uint32_t> order(num);
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(),
+            [tuple_ids](uint32_t a, uint32_t b) { return tuple_ids[a] < tuple_ids[b]; });
+  std::vector<uint32_t> ids(num), blocks(num);
+  for (size_t i = 0; i < num; ++i) ids[i] = tuple_ids[order[i]];
+  index_reader_.FindBlocks(ids.data(), num, blocks.data());
+  // the tuples of the r-th block looked up are [runs[r], runs[r + 1]) of ids
+  std::vector<size_t> runs;
+  for (size_t i = 0; i < num; ++i)
+    if (i == 0 || blocks[i] != blocks[i - 1]) runs.push_back(i);
+  const size_t num_runs = runs.size();
+  runs.push_back(num);
+
+  // requests run ahead of decoding in three stages, see kLookupGroupSize
+  auto prefetch = [&](size_t r) {
+    if (r + 3 * kLookupGroupSize < num_runs)
+      index_reader_.PrefetchBlock(static_cast<int>(blocks[runs[r + 3 * kLookupGroupSize]]));
+    if (r + 2 * kLookupGroupSize < num_runs) {
+      size_t i = runs[r + 2 * kLookupGroupSize];
+      PrefetchSeek(static_cast<int>(blocks[i]), ids[i], false);
+    }
+    if (r + kLookupGroupSize < num_runs) {
+      size_t i = runs[r + kLookupGroupSize];
+      PrefetchSeek(static_cast<int>(blocks[i]), ids[i], true);
+    }
+  };
+  for (size_t r = 0; r < 3 * kLookupGroupSize; ++r) {
+    if (r < num_runs) index_reader_.PrefetchBlock(static_cast<int>(blocks[runs[r]]));
+  }
+
+  AttrVector tuple(static_cast<int>(schema_.size()));
+  const uint32_t checkpoint_tuples = index_reader_.CheckpointTuples();
+  // tuples decoded since the last seek, they are cached under where decoding started
+  std::vector<AttrVector> decoded;
+  uint32_t run_start = 0;
+  auto cache_decoded = [&]() {
+    if (block_cache_ != nullptr && !decoded.empty())
+      block_cache_->Insert(run_start, std::move(decoded));
+    decoded.clear();
+  };
+  for (size_t r = 0; r < num_runs; ++r) {
+    prefetch(r);
+    // decode the block up to the last tuple wanted from it, skip ahead to a checkpoint if it is
+    // closer than the next wanted tuple, and skip tuples found in the block cache
+    int block_idx = static_cast<int>(blocks[runs[r]]);
+    uint32_t first_tuple = index_reader_.BlockFirstTuple(block_idx);
+    uint32_t idx = index_reader_.BlockFirstTuple(block_idx + 1);
+    for (size_t i = runs[r]; i < runs[r + 1];) {
+      uint32_t tuple_idx = ids[i];
+      uint32_t checkpoint = index_reader_.FindCheckpoint(block_idx, tuple_idx - first_tuple);
+      uint32_t start = first_tuple + checkpoint * checkpoint_tuples;
+      const AttrVector *result = &tuple;
+      const AttrVector *cached =
+          block_cache_ != nullptr ? block_cache_->Find(start, tuple_idx - start) : nullptr;
+      if (cached != nullptr) {
+        result = cached;
+      } else {
+        if (idx > tuple_idx || idx < start) {
+          cache_decoded();
+          SeekBlock(block_idx, checkpoint);
+          idx = start;
+          run_start = start;
+        }
+        for (; idx <= tuple_idx; ++idx) {
+          DecodeNext(&tuple);
+          if (block_cache_ != nullptr) decoded.push_back(tuple);
+        }
       }
+      for (; i < runs[r + 1] && ids[i] == tuple_idx; ++i) tuples[order[i]] = *result;
+    }
+    cache_decoded();
+  }
+  num_todo_tuples_ = 0;
+  num_converted_tuples_ = 0;
+  cached_tuple_ = nullptr;
+}
+
+void RelationDecompressor::PrefetchSeek(int block_idx, uint32_t tuple_idx, bool data) const {
+  uint32_t checkpoint =
+      index_reader_.FindCheckpoint(block_idx, tuple_idx - index_reader_.BlockFirstTuple(block_idx));
+  uint64_t num_bytes = index_reader_.BlockPosition(block_idx);
+  if (checkpoint > 0) {
+    const DecoderCheckpoint &state = index_reader_.Checkpoint(block_idx, checkpoint);
+    if (!data) {
+      const auto *lines = reinterpret_cast<const char *>(&state);
+      for (size_t i = 0; i < sizeof(DecoderCheckpoint); i += 64) __builtin_prefetch(lines + i);
+      return;
     }
+    num_bytes += static_cast<uint64_t>(state.num_words_) << 1;
   }
+  if (!data) return;
+  const unsigned char *bytes = byte_reader_.Data() + (data_pos_ >> 3) + num_bytes;
+  for (int i = 0; i < kLookupPrefetchLines; ++i) __builtin_prefetch(bytes + 64 * i);
+}
+
+void RelationDecompressor::ReadNextTuple(AttrVector *tuple) {
+  if (cached_tuple_ != nullptr) {
+    *tuple = *cached_tuple_;
+    num_converted_tuples_++;
+    return;
+  }
+  const int block_size = rans_ ? rans_decoder_.CurBlockSize() : decoder_.CurBlockSize();
+  if (block_size > block_size_threshold_) {
+    InitBlock();
+    if (read_ahead_ != nullptr) read_ahead_->Advance(byte_reader_.Tellg() >> 3);
+  }
+
+  DecodeNext(tuple);
   num_converted_tuples_++;
+  if (random_access_ && block_cache_ != nullptr) {
+    block_tuples_.push_back(*tuple);
+    if (num_converted_tuples_ == num_todo_tuples_)
+      block_cache_->Insert(run_start_, std::move(block_tuples_));
+  }
   //  if (num_converted_tuples_ % 500000 == 0) {
   //    std::cout << "Decompressed Tuples: " << num_converted_tuples_ << "\n";
   //  }
@@ -102,48 +340,122 @@ void RelationDecompressor::ReadNextTuple(AttrVector *tuple) {
 
 void RelationDecompressor::ReadTargetTuple(size_t tuple_idx, AttrVector *tuple) {
   assert(tuple_idx < num_total_tuples_);
-  num_bytes_ = index_reader_.LocateTuple(tuple_idx);
-  byte_reader_.SetPos(data_pos_ + (num_bytes_ << 3));
-  decoder_.InitProbInterval();
+  AdviseRandomAccess();
+  // one tuple per block, so the tuple index is the block index
+  SeekBlock(static_cast<int>(tuple_idx), 0);
 
-  for (int attr_index : attr_order_) {
+  DecodeNext(tuple);
+}
+
+template <class Engine>
+void RelationDecompressor::BuildPlan(std::vector<std::unique_ptr<SquIDModel> > &models,
+                                     TupleDecodePlan<Engine> *plan) const {
+  plan->clear();
+  for (size_t attr_index : attr_order_) {
+    SquIDModel *model = models[attr_index].get();
+    const bool bound = model->GetPredictorList().empty();
+    TupleDecodeStep<Engine> step{nullptr, model, nullptr, attr_index};
     switch (schema_.attr_type_[attr_index]) {
       case 0: {
-        auto *model = static_cast<TableCategorical *>(model_[attr_index].get());
-        CategoricalSquID *squid = model->GetSquID(*tuple);
-        squid->Decompress(&decoder_, &byte_reader_);
-        // tuple->attr_[attr_index] = squid->GetResultAttr();
-        break;
-      }
-      case 1: {
-        auto *model = static_cast<TableNumerical *>(model_[attr_index].get());
-        NumericalSquID *squid = model->GetSquID(*tuple);
-        squid->Decompress(&decoder_, &byte_reader_);
-        // tuple->attr_[attr_index] = squid->GetResultAttr(true);
+        if (bound) {
+          step.decode_ = DecodeBound<Engine, CategoricalSquID>;
+          step.squid_ = &static_cast<TableCategorical *>(model)->base_squid_;
+        } else {
+          step.decode_ = DecodeWithPredictors<Engine, TableCategorical, CategoricalSquID>;
+        }
         break;
       }
+      case 1:
       case 2: {
-        auto *model = static_cast<TableNumerical *>(model_[attr_index].get());
-        NumericalSquID *squid = model->GetSquID(*tuple);
-        squid->Decompress(&decoder_, &byte_reader_);
-        // tuple->attr_[attr_index] = squid->GetResultAttr(true);
+        if (bound) {
+          step.decode_ = DecodeBound<Engine, NumericalSquID>;
+          step.squid_ = &static_cast<TableNumerical *>(model)->base_squid_;
+        } else {
+          step.decode_ = DecodeWithPredictors<Engine, TableNumerical, NumericalSquID>;
+        }
         break;
       }
       case 3: {
-        auto *model = static_cast<StringModel *>(model_[attr_index].get());
-        model->squid_.Decompress(&decoder_, &byte_reader_);
-        // tuple->attr_[attr_index] = model->squid_.GetResultAttr();
+        step.decode_ = DecodeBound<Engine, StringSquID>;
+        step.squid_ = &static_cast<StringModel *>(model)->squid_;
         break;
       }
       case 5: {
-        auto *model = static_cast<TableMarkov *>(model_[attr_index].get());
-        CategoricalSquID *squid = model->GetSquID(*tuple);
-        squid->Decompress(&decoder_, &byte_reader_);
-        // tuple->attr_[attr_index] = squid->GetResultAttr();
-        model->SetState(tuple->attr_[attr_index].Int());
+        step.decode_ = DecodeMarkov<Engine>;
         break;
       }
+      default:
+        std::cerr << "Unsupported Data Attribute.\n";
+        continue;
     }
+    plan->push_back(step);
+  }
+}
+
+void RelationDecompressor::ParallelScan(
+    int num_threads, const std::function<void(int, size_t, const AttrVector &)> &callback) {
+  const int num_blocks = index_reader_.NumBlocks();
+  num_threads = std::max(1, std::min(num_threads, num_blocks));
+
+  // Models keep decompression states, every thread needs its own copy. Models are loaded here
+  // since model creators and attribute interpreters are shared.
+  std::vector<std::vector<std::unique_ptr<SquIDModel> > > models(num_threads);
+  std::vector<TupleDecodePlan<Decoder> > plans(rans_ ? 0 : num_threads);
+  std::vector<TupleDecodePlan<RansDecoder> > rans_plans(rans_ ? num_threads : 0);
+  for (int i = 0; i < num_threads; ++i) {
+    ByteReader byte_reader(byte_reader_);
+    byte_reader.SetPos(model_pos_);
+    ReadModels(&byte_reader, &models[i]);
+    if (rans_)
+      BuildPlan(models[i], &rans_plans[i]);
+    else
+      BuildPlan(models[i], &plans[i]);
+  }
+
+  // Blocks are read once and in order, pages behind a worker are dropped
+  byte_reader_.Advise(data_pos_ >> 3, data_size_, MapAdvice::kSequential);
+  random_access_ = false;
+  auto worker = [&](auto decoder, const auto &plan, int thread_id, int first_block,
+                    int last_block) {
+    ByteReader byte_reader(byte_reader_);
+    decoder.Configure(coding_config_);
+    AttrVector tuple(static_cast<int>(schema_.size()));
+    uint64_t released = (data_pos_ >> 3) + index_reader_.BlockPosition(first_block);
+    uint64_t end_pos = (data_pos_ >> 3) + index_reader_.BlockPosition(last_block);
+    ReadAhead read_ahead(byte_reader, released, end_pos);
+    for (int block = first_block; block < last_block; ++block) {
+      uint64_t block_pos = (data_pos_ >> 3) + index_reader_.BlockPosition(block);
+      read_ahead.Advance(block_pos);
+      if (block_pos - released >= kScanResidentBytes) {
+        byte_reader.Advise(released, block_pos - released, MapAdvice::kDontNeed);
+        released = block_pos;
+      }
+      byte_reader.SetPos(block_pos << 3);
+      decoder.InitProbInterval();
+      for (auto &model : models[thread_id]) model->ResetState();
+      const uint32_t block_end = std::min<uint32_t>(index_reader_.BlockFirstTuple(block + 1),
+                                                    num_total_tuples_);
+      for (uint32_t idx = index_reader_.BlockFirstTuple(block); idx < block_end; ++idx) {
+        DecodeTuple(plan, &decoder, &byte_reader, &tuple);
+        callback(thread_id, idx, tuple);
+      }
+    }
+    byte_reader.Advise(released, end_pos - released, MapAdvice::kDontNeed);
+  };
+
+  std::vector<std::thread> workers;
+  for (int i = 0; i < num_threads; ++i) {
+    int first_block = static_cast<int>(static_cast<int64_t>(num_blocks) * i / num_threads);
+    int last_block = static_cast<int>(static_cast<int64_t>(num_blocks) * (i + 1) / num_threads);
+    if (rans_)
+      workers.emplace_back([&, i, first_block, last_block]() {
+        worker(RansDecoder(), rans_plans[i], i, first_block, last_block);
+      });
+    else
+      workers.emplace_back([&, i, first_block, last_block]() {
+        worker(Decoder(), plans[i], i, first_block, last_block);
+      });
   }
+  for (std::thread &thread : workers) thread.join();
 }
 }  // namespace db_compress
@@ -112,8 +112,11 @@ void NumericalStats::WriteStats(SequenceByteWriter *byte_writer) const {
   byte_writer->Write32Bit(bytes);
   ConvertSinglePrecision(mean_abs_dev_, bytes);
   byte_writer->Write32Bit(bytes);
-  byte_writer->WriteUint64(branch_bins_est_);
-  for (int i = 0; i < kNumBranch; ++i) byte_writer->Write32Bit(branch_weights_[i]);
+  byte_writer->WriteVarint(branch_bins_est_);
+  // a stat without data has no weights yet
+  std::vector<uint32_t> weights(branch_weights_);
+  weights.resize(kNumBranch, 0);
+  WriteWeights(weights, byte_writer);
 }
 
 void NumericalStats::ReadStats(ByteReader *byte_reader) {
@@ -122,10 +125,10 @@ void NumericalStats::ReadStats(ByteReader *byte_reader) {
   mid_est_ = ConvertSinglePrecision(bytes);
   byte_reader->Read32Bit(bytes);
   mean_abs_dev_ = ConvertSinglePrecision(bytes);
-  branch_bins_est_ = byte_reader->ReadUint64();
+  branch_bins_est_ = byte_reader->ReadVarint();
 
   branch_weights_.resize(kNumBranch);
-  for (int i = 0; i < kNumBranch; ++i) branch_weights_[i] = byte_reader->ReadUint32();
+  ReadWeights(byte_reader, &branch_weights_);
 
   InitDelayedCodingParams(branch_weights_, coding_params_);
   Prepare();
@@ -290,7 +293,8 @@ void NumericalSquID::GetHistogramProbIntervals(std::vector<Branch *> &prob_inter
   prob_intervals[prob_intervals_index++] = GetSimpleBranch(weight_branch_last_layer_, low_bits);
 }
 
-void NumericalSquID::Decompress(Decoder *decoder, ByteReader *byte_reader) {
+template <class Engine>
+void NumericalSquID::Decompress(Engine *decoder, ByteReader *byte_reader) {
   Reset();
 
   unsigned two_bytes = decoder->Read16Bits(byte_reader);
@@ -322,7 +326,8 @@ void NumericalSquID::Decompress(Decoder *decoder, ByteReader *byte_reader) {
   }
 }
 
-void NumericalSquID::ExpDecompress(Decoder *decoder, ByteReader *byte_reader) {
+template <class Engine>
+void NumericalSquID::ExpDecompress(Engine *decoder, ByteReader *byte_reader) {
   unsigned two_bytes;
   unsigned numerator;
   unsigned branch;
@@ -354,7 +359,8 @@ void NumericalSquID::ExpDecompress(Decoder *decoder, ByteReader *byte_reader) {
   }
 }
 
-void NumericalSquID::HistogramDecompress(Decoder *decoder, ByteReader *byte_reader) {
+template <class Engine>
+void NumericalSquID::HistogramDecompress(Engine *decoder, ByteReader *byte_reader) {
   int64_t branch = 0;
   if (num_layer_ != 0) {
     for (int i = num_layer_; i > 0; --i) branch = (branch << 16) | decoder->Read16Bits(byte_reader);
@@ -373,6 +379,9 @@ void NumericalSquID::HistogramDecompress(Decoder *decoder, ByteReader *byte_read
   decoder->Update(denominator, numerator);
 }
 
+template void NumericalSquID::Decompress(Decoder *decoder, ByteReader *byte_reader);
+template void NumericalSquID::Decompress(RansDecoder *decoder, ByteReader *byte_reader);
+
 AttrValue &NumericalSquID::GetResultAttr(bool round) {
   if (!HasNextBranch()) {
     if (target_int_) {
@@ -474,8 +483,14 @@ void TableNumerical::EndOfData() {
 
 int TableNumerical::GetModelDescriptionLength() const {
   size_t table_size = dynamic_list_.Size();
-  // See WriteModel function for details of model description.
-  return table_size * (32 * (4 + kNumBranch + 1)) + predictor_list_size_ * 16 + 40;
+  // See WriteModel function for details of model description. A cell without data takes a byte.
+  size_t length = 0;
+  for (size_t i = 0; i < table_size; ++i) {
+    const NumericalStats &stat = dynamic_list_[i];
+    length += 1;
+    if (i == 0 || stat.v_count_ != 0) length += 8 + 3 + GetWeightsLength(stat.branch_weights_);
+  }
+  return static_cast<int>(length * 8 + predictor_list_size_ * 16 + 40);
 }
 
 void TableNumerical::WriteModel(SequenceByteWriter *byte_writer) {
@@ -488,12 +503,18 @@ void TableNumerical::WriteModel(SequenceByteWriter *byte_writer) {
   ConvertSinglePrecision(bin_size_, bytes);
   byte_writer->Write32Bit(bytes);
 
-  // Write Model Parameters
+  // Write Model Parameters. A cell is led by 0 if its stat follows, or by 1 if it is a copy of the
+  // first cell.
   size_t table_size = dynamic_list_.Size();
   for (size_t i = 0; i < table_size; ++i) {
     NumericalStats &stat = dynamic_list_[i];
     // suppose this stat does not have any data, we do not write it and use the first stat instead.
-    if (stat.v_count_ == 0) stat = dynamic_list_[0];
+    if (i > 0 && stat.v_count_ == 0) {
+      stat = dynamic_list_[0];
+      byte_writer->WriteVarint(1);
+      continue;
+    }
+    byte_writer->WriteVarint(0);
     stat.WriteStats(byte_writer);
   }
 }
@@ -514,7 +535,11 @@ TableNumerical *TableNumerical::ReadModel(ByteReader *byte_reader, const Schema
   size_t table_size = model->dynamic_list_.Size();
   for (size_t i = 0; i < table_size; ++i) {
     NumericalStats &stat = model->dynamic_list_[i];
-    stat.ReadStats(byte_reader);
+    // a copy of the first cell needs no delayed coding params to be computed
+    if (byte_reader->ReadVarint() == 1)
+      stat = model->dynamic_list_[0];
+    else
+      stat.ReadStats(byte_reader);
   }
 
   model->base_squid_.Init(model->dynamic_list_[0]);
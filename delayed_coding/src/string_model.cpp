@@ -3,13 +3,14 @@
 #include <vector>
 
 namespace db_compress {
-StringModel::StringModel(size_t target_var)
+StringModel::StringModel(size_t target_var, int local_dict_size)
     : SquIDModel(std::vector<size_t>(), target_var),
       global_dictionary_(8192),
       markov_char_dist_(kMarkovModel),
       word_length_(true, 1),
-      local_dict_(kLocalDictSize),
-      squid_(kLocalDictSize) {}
+      local_dict_size_(local_dict_size),
+      local_dict_(local_dict_size),
+      squid_(local_dict_size) {}
 
 StringSquID *StringModel::GetSquID(const AttrVector &tuple) {
   squid_.Init(GenerateStringStats());
@@ -17,13 +18,9 @@ StringSquID *StringModel::GetSquID(const AttrVector &tuple) {
 }
 
 void StringModel::FeedAttrs(const AttrVector &attrs, int count) {
-#if kLocalDictSize > 0
   // get sentence
   const std::string &string = attrs.attr_[target_var_].String();
-  const std::string &sentence = CheckLocalDict(count, string);
-#else
-  const std::string &sentence = attrs.attr_[target_var_].String();
-#endif
+  const std::string &sentence = local_dict_size_ > 0 ? CheckLocalDict(count, string) : string;
 
   // parse sentence
   squid_.splitter_.ParseString(sentence);
@@ -100,11 +97,11 @@ void StringModel::EndOfData() {
   // init global dictionary
   global_dictionary_.EndOfData(encoding_methods_, squid_.splitter_);
 
-#if kLocalDictSize > 0
   // init local dictionary
-  delta_encoding_.EndOfData();
-  dict_idx_.EndOfData();
-#endif
+  if (local_dict_size_ > 0) {
+    delta_encoding_.EndOfData();
+    dict_idx_.EndOfData();
+  }
 
   // end of squid learning
   delimiter_type_.EndOfData();
@@ -123,6 +120,7 @@ int StringModel::GetModelCost() const {
 int StringModel::GetModelDescriptionLength() const { return 255 * 16 + 63 * 8; }
 
 void StringModel::WriteModel(SequenceByteWriter *byte_writer) {
+  byte_writer->Write16Bit(local_dict_size_);
   markov_char_dist_.WriteMarkov(byte_writer);
 
   delimiter_type_.WriteModel(byte_writer);
@@ -130,16 +128,17 @@ void StringModel::WriteModel(SequenceByteWriter *byte_writer) {
   num_words_squid_.WriteModel(byte_writer);
   word_length_.WriteModel(byte_writer);
 
-#if kLocalDictSize > 0
-  delta_encoding_.WriteModel(byte_writer);
-  dict_idx_.WriteModel(byte_writer);
-#endif
+  if (local_dict_size_ > 0) {
+    delta_encoding_.WriteModel(byte_writer);
+    dict_idx_.WriteModel(byte_writer);
+  }
 
   global_dictionary_.WriteDictionary(byte_writer, GetSquID(AttrVector(0)));
 }
 
 StringModel *StringModel::ReadModel(ByteReader *byte_reader, size_t index) {
-  StringModel *model = new StringModel(index);
+  int local_dict_size = byte_reader->Read16Bit();
+  StringModel *model = new StringModel(index, local_dict_size);
 
   model->markov_char_dist_.ReadMarkov(byte_reader);
 
@@ -153,11 +152,11 @@ StringModel *StringModel::ReadModel(ByteReader *byte_reader, size_t index) {
   TableNumericalIntCreator creator;
   model->word_length_ = *static_cast<TableNumerical *>(creator.ReadModel(byte_reader, Schema(), 0));
 
-#if kLocalDictSize > 0
-  model->delta_encoding_ =
-      *static_cast<TableCategorical *>(TableCategorical::ReadModel(byte_reader));
-  model->dict_idx_ = *static_cast<TableCategorical *>(TableCategorical::ReadModel(byte_reader));
-#endif
+  if (local_dict_size > 0) {
+    model->delta_encoding_ =
+        *static_cast<TableCategorical *>(TableCategorical::ReadModel(byte_reader));
+    model->dict_idx_ = *static_cast<TableCategorical *>(TableCategorical::ReadModel(byte_reader));
+  }
 
   model->squid_.Init(model->GenerateStringStats());
   model->global_dictionary_.LoadDictionary(byte_reader, model->GetSquID(AttrVector(0)));
@@ -173,10 +172,10 @@ StringStats StringModel::GenerateStringStats() {
   stats.word_length_squid_ = word_length_.GetSquID();
   stats.encoding_method_squid_ = encoding_methods_.GetSquID();
 
-#if kLocalDictSize > 0
-  stats.delta_encoding_ = delta_encoding_.GetSquID();
-  stats.dict_idx_ = dict_idx_.GetSquID();
-#endif
+  if (local_dict_size_ > 0) {
+    stats.delta_encoding_ = delta_encoding_.GetSquID();
+    stats.dict_idx_ = dict_idx_.GetSquID();
+  }
 
   stats.markov_dist_ = &markov_char_dist_;
   stats.global_dict_ = &global_dictionary_;
@@ -193,6 +192,6 @@ SquIDModel *StringModelCreator::CreateModel(const std::vector<int> &attr_type,
                                             double err) {
   if (!predictor.empty()) return nullptr;
 
-  return new StringModel(index);
+  return new StringModel(index, local_dict_size_);
 }
 }  // namespace db_compress
@@ -1,5 +1,9 @@
 #include "string_squid.h"
 
+#include <map>
+
+#include "utility.h"
+
 namespace db_compress {
 // MarkovCharDist
 MarkovCharDist::MarkovCharDist(int history_length) : history_length_(history_length) {
@@ -79,6 +83,7 @@ void MarkovCharDist::EndOfData() {
       stats.weight_[index_max_weight] += left_weight;
 
     InitDelayedCodingParams(stats.weight_, stats.coding_params_);
+    stats.InitDecodeTable();
   }
 
   // 2. clear history
@@ -88,15 +93,17 @@ void MarkovCharDist::EndOfData() {
 
 void MarkovCharDist::WriteMarkov(SequenceByteWriter *byte_writer) const {
   byte_writer->Write16Bit(num_markov_table_);
+  // A table with the same weights as an earlier table is written as the index of that table plus
+  // one, otherwise 0 is followed by its weights.
+  std::map<std::vector<unsigned>, int> written;
   for (int i = 0; i < num_markov_table_; ++i) {
-    std::vector<unsigned> weights = markov_table_stats_[i].weight_;
-    for (size_t j = 0; j < weights.size(); ++j) {
-      // 65536 cannot be represented by 16 bits. Once there is a 65536 weight branch, then all left
-      // weights are zero. So, we use 65535 to represent 65536.
-      if (weights[j] == 65536)
-        byte_writer->Write16Bit(65535);
-      else
-        byte_writer->Write16Bit(weights[j]);
+    const std::vector<unsigned> &weights = markov_table_stats_[i].weight_;
+    auto it = written.emplace(weights, i);
+    if (!it.second) {
+      byte_writer->WriteVarint(it.first->second + 1);
+    } else {
+      byte_writer->WriteVarint(0);
+      WriteWeights(weights, byte_writer);
     }
   }
 }
@@ -106,22 +113,18 @@ void MarkovCharDist::ReadMarkov(ByteReader *byte_reader) {
   num_markov_table_ = static_cast<int>(byte_reader->Read16Bit());
   for (int i = 0; i < num_markov_table_; ++i) {
     CategoricalStats &stats = markov_table_stats_[i];
+    // a table equal to an earlier one is copied, delayed coding params included
+    size_t same_table = byte_reader->ReadVarint();
+    if (same_table > 0) {
+      stats = markov_table_stats_[same_table - 1];
+      continue;
+    }
 
     // Read weights
-    size_t only_value = -1;
-    unsigned sum_weights = 0;
-    for (size_t j = 0; j < stats.weight_.size(); ++j) {
-      stats.weight_[j] = byte_reader->Read16Bit();
-      sum_weights += stats.weight_[j];
-
-      // label branch of weight 65535, there could be only one 65535 weight branch.
-      if (stats.weight_[j] == 65535) only_value = j;
-    }
-    // If sum of weights is not 65536, it means ''only value'' exists.
-    if (sum_weights != 65536) {
-      stats.weight_[only_value] = 65536;
-      stats.only_value_ = only_value;
-    }
+    ReadWeights(byte_reader, &stats.weight_);
+    // a branch of weight 65536 is the ''only value''
+    for (size_t j = 0; j < stats.weight_.size(); ++j)
+      if (stats.weight_[j] == 65536) stats.only_value_ = j;
 
     // init rare branch handler
     if (stats.weight_[stats.weight_.size() - 1] != 0)
@@ -129,6 +132,7 @@ void MarkovCharDist::ReadMarkov(ByteReader *byte_reader) {
 
     // Preparation for delayed coding
     InitDelayedCodingParams(stats.weight_, stats.coding_params_);
+    stats.InitDecodeTable();
   }
 }
 
@@ -194,7 +198,8 @@ void MarkovCharDist::GetMarkovProbInterval(std::vector<Branch *> &prob_intervals
   }
 }
 
-void MarkovCharDist::MarkovDecompress(Decoder *decoder, ByteReader *byte_reader, std::string &word,
+template <class Engine>
+void MarkovCharDist::MarkovDecompress(Engine *decoder, ByteReader *byte_reader, std::string &word,
                                       int word_length) {
   Reset();
 
@@ -207,6 +212,11 @@ void MarkovCharDist::MarkovDecompress(Decoder *decoder, ByteReader *byte_reader,
   }
 }
 
+template void MarkovCharDist::MarkovDecompress(Decoder *decoder, ByteReader *byte_reader,
+                                               std::string &word, int word_length);
+template void MarkovCharDist::MarkovDecompress(RansDecoder *decoder, ByteReader *byte_reader,
+                                               std::string &word, int word_length);
+
 // StringSquID
 void StringSquID::Init(StringStats stat) { stats_ = stat; }
 
@@ -217,13 +227,10 @@ void StringSquID::GetProbIntervals(std::vector<Branch *> &prob_intervals, int &p
   int end;
   int delimiter;
 
-#if kLocalDictSize > 0
   // 0. Local Dictionary
   const std::string &string = value.String();
-  const std::string &sentence = CheckLocalDict(prob_intervals, prob_intervals_index, string);
-#else
-  const std::string &sentence = value.String();
-#endif
+  const std::string &sentence =
+      local_dict_.empty() ? string : CheckLocalDict(prob_intervals, prob_intervals_index, string);
 
   // 1. Parse sentence
   splitter_.ParseString(sentence);
@@ -339,21 +346,19 @@ void StringSquID::NormalCompress(std::vector<Branch *> &prob_intervals, int &pro
   stats_.markov_dist_->GetMarkovProbInterval(prob_intervals, prob_intervals_index, word);
 }
 
-void StringSquID::Decompress(Decoder *decoder, ByteReader *byte_reader) {
-#if kLocalDictSize > 0
-  // read delta
-  stats_.delta_encoding_->Decompress(decoder, byte_reader);
-  int delta = stats_.delta_encoding_->GetResultAttr().Int();
-  if (delta != 0) {
-    stats_.dict_idx_->Decompress(decoder, byte_reader);
-    int dict_idx = stats_.dict_idx_->GetResultAttr().Int();
-    attr_.value_ = (local_dict_[dict_idx].substr(0, delta));
-  } else {
-    attr_.value_ = ("");
-  }
-#else
+template <class Engine>
+void StringSquID::Decompress(Engine *decoder, ByteReader *byte_reader) {
   attr_.value_ = ("");
-#endif
+  if (!local_dict_.empty()) {
+    // read delta
+    stats_.delta_encoding_->Decompress(decoder, byte_reader);
+    int delta = stats_.delta_encoding_->GetResultAttr().Int();
+    if (delta != 0) {
+      stats_.dict_idx_->Decompress(decoder, byte_reader);
+      int dict_idx = stats_.dict_idx_->GetResultAttr().Int();
+      attr_.value_ = (local_dict_[dict_idx].substr(0, delta));
+    }
+  }
 
   // read number of words
   stats_.num_terms_squid_->Decompress(decoder, byte_reader);
@@ -386,13 +391,14 @@ void StringSquID::Decompress(Decoder *decoder, ByteReader *byte_reader) {
       attr_.String().push_back(splitter_.id2delimiters_[delimiter_id]);
   }
 
-#if kLocalDictSize > 0
-  local_dict_.pop_front();
-  local_dict_.push_back(attr_.String());
-#endif
+  if (!local_dict_.empty()) {
+    local_dict_.pop_front();
+    local_dict_.push_back(attr_.String());
+  }
 }
 
-std::string &StringSquID::NormalDecompress(Decoder *decoder, ByteReader *byte_reader) {
+template <class Engine>
+std::string &StringSquID::NormalDecompress(Engine *decoder, ByteReader *byte_reader) {
   // read word length
   stats_.word_length_squid_->Decompress(decoder, byte_reader);
   int word_length = stats_.word_length_squid_->GetResultAttr(true).Int();
@@ -407,4 +413,10 @@ std::string &StringSquID::NormalDecompress(Decoder *decoder, ByteReader *byte_re
 
   return word_buffer_;
 }
+
+template void StringSquID::Decompress(Decoder *decoder, ByteReader *byte_reader);
+template void StringSquID::Decompress(RansDecoder *decoder, ByteReader *byte_reader);
+template std::string &StringSquID::NormalDecompress(Decoder *decoder, ByteReader *byte_reader);
+template std::string &StringSquID::NormalDecompress(RansDecoder *decoder,
+                                                    ByteReader *byte_reader);
 }  // namespace db_compress
@@ -86,7 +86,8 @@ void GlobalDictionary::GetProbIntervals(std::vector<Branch *> &prob_intervals,
   squid_.GetSquID()->GetProbIntervals(prob_intervals, prob_intervals_index, AttrValue(word_id));
 }
 
-std::string &GlobalDictionary::Decompress(Decoder *decoder, ByteReader *byte_reader,
+template <class Engine>
+std::string &GlobalDictionary::Decompress(Engine *decoder, ByteReader *byte_reader,
                                           bool &is_phrase) {
   CategoricalTreeSquid *squid = squid_.GetSquID();
   squid->Decompress(decoder, byte_reader);
@@ -95,6 +96,11 @@ std::string &GlobalDictionary::Decompress(Decoder *decoder, ByteReader *byte_rea
   return id_to_term_[id];
 }
 
+template std::string &GlobalDictionary::Decompress(Decoder *decoder, ByteReader *byte_reader,
+                                                   bool &is_phrase);
+template std::string &GlobalDictionary::Decompress(RansDecoder *decoder, ByteReader *byte_reader,
+                                                   bool &is_phrase);
+
 void GlobalDictionary::EndOfData(TableCategorical &encoding_methods, StringSplitter &splitter) {
   // word_counts analysis
   // AnalyzeWordCount();
@@ -180,8 +186,8 @@ void GlobalDictionary::CountPhrases(const StringSplitter &splitter, int &num_tot
 }
 
 void GlobalDictionary::WriteDictionary(SequenceByteWriter *byte_writer, StringSquID *string_squid) {
-  byte_writer->Write32Bit(line_);
-  byte_writer->Write32Bit(id_to_term_.size());
+  byte_writer->WriteVarint(line_);
+  byte_writer->WriteVarint(id_to_term_.size());
   squid_.WriteModel(byte_writer);
 
   unsigned bits = 0;
@@ -216,8 +222,8 @@ void GlobalDictionary::WriteDictionary(SequenceByteWriter *byte_writer, StringSq
 }
 
 void GlobalDictionary::LoadDictionary(ByteReader *byte_reader, StringSquID *string_squid) {
-  line_ = byte_reader->Read32Bit();
-  int size = byte_reader->Read32Bit();
+  line_ = static_cast<int>(byte_reader->ReadVarint());
+  int size = static_cast<int>(byte_reader->ReadVarint());
   squid_ = *static_cast<TableCategoricalTree *>(TableCategoricalTree::ReadModel(byte_reader));
   id_to_term_.resize(size);
 
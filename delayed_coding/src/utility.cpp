@@ -1,10 +1,11 @@
 #include "../include/utility.h"
 
+#include <algorithm>
 #include <cmath>
 
 #include <iostream>
-#include <sstream>
-#include <unistd.h>
+
+#include "../include/blitzcrank_exception.h"
 
 namespace db_compress {
     void QuantizationToFloat32Bit(double *val) {
@@ -52,27 +53,6 @@ namespace db_compress {
         return ret;
     }
 
-    namespace {
-/**
- * Given a branch and a fraction, the final delayed coding bytes can be
- * generated. That is, we want to find the right position in [0, 65535] to
- * encode two information: 1) branch; 2) numerator.
- *
- * @param branch all the segments of a specific branch
- * @param num numerator of fraction
- * @return
- */
-        uint16_t GetEmbeddedBytes(const Branch *branch, uint64_t num) {
-            for (const ProbInterval &segment: branch->segments_) {
-                if (segment.right_prob_ - segment.left_prob_ > num) {
-                    return segment.left_prob_ + num;
-                }
-                num -= (segment.right_prob_ - segment.left_prob_);
-            }
-
-            return -1;
-        }
-    }  // namespace
     void InitDelayedCodingParams(std::vector<unsigned int> &weights, DelayedCodingParams &params) {
         // if there is no branch, it means attribute has only one possible value,
         // return
@@ -204,50 +184,164 @@ namespace db_compress {
         for (int i = 0; i < branches.size(); ++i) {
             if (branches[i].segments_.empty() && branches[i].total_weights_ != 0)
                 std::cout << "InitDelayedCodingParams::segments_ cannot be empty.\n";
+            branches[i].Prepare();
         }
     }
 
     void DelayedCoding(const std::vector<Branch *> &prob_intervals, int &interval_size,
-                       BitString *bit_string, std::vector<bool> &sym_is_virtual) {
+                       BitString *bit_string, std::vector<bool> &sym_is_virtual,
+                       const DelayedCodingConfig &config,
+                       const std::vector<int> *checkpoint_intervals,
+                       std::vector<DecoderCheckpoint> *checkpoints) {
         for (int i = 0; i < interval_size; ++i) {
             assert(prob_intervals[i]->segments_.size() > 0);
             assert(prob_intervals[i]->total_weights_ > 0);
         }
+        if (!config.IsValid())
+            throw BlitzcrankException("DelayedCoding::Unsupported delayed coding engine.\n");
 
         bit_string->num_ = 0;
-
-        // First Run.
-        uint64_t den = 1;
-        bool has_virtual = false;
+        const int num_states = config.num_states_;
+        const int state_mask = num_states - 1;
+        const int precision = config.precision_;
+        const int renorm_bits = config.renorm_bits_;
+        const int words_per_renorm = renorm_bits >> 4;
+
+        // First Run. A renormalization turns the following words_per_renorm
+        // probability intervals of the same state into virtual ones.
+        uint64_t den[kMaxInterleavedStates];
+        int num_virtual[kMaxInterleavedStates];
+        for (int s = 0; s < num_states; ++s) {
+            den[s] = 1;
+            num_virtual[s] = 0;
+        }
+        // Checkpoints take den and virtual words from the first run, the number of words read
+        // before them, and num from the second run.
+        const size_t num_checkpoints = checkpoint_intervals == nullptr ? 0 : checkpoint_intervals->size();
+        if (num_checkpoints > 0) checkpoints->resize(num_checkpoints);
+        size_t next_checkpoint = 0;
+        uint32_t num_words = 0;
         for (size_t i = 0; i < interval_size; ++i) {
-            sym_is_virtual[i] = has_virtual;
-            has_virtual = false;
-
-            den *= prob_intervals[i]->total_weights_;
-            if ((den >> kDelayedCoding) > 0) {
-                has_virtual = true;
-                den >>= 16;
+            const int s = i & state_mask;
+            while (next_checkpoint < num_checkpoints && (*checkpoint_intervals)[next_checkpoint] == i) {
+                DecoderCheckpoint &checkpoint = (*checkpoints)[next_checkpoint++];
+                checkpoint.interval_ = static_cast<uint32_t>(i);
+                checkpoint.num_words_ = num_words;
+                for (int k = 0; k < num_states; ++k) {
+                    checkpoint.den_[k] = den[k];
+                    checkpoint.num_virtual_[k] = static_cast<uint16_t>(num_virtual[k]);
+                }
+            }
+            num_words += num_virtual[s] == 0;
+            sym_is_virtual[i] = num_virtual[s] > 0;
+            if (num_virtual[s] > 0) --num_virtual[s];
+
+            den[s] *= prob_intervals[i]->total_weights_;
+            if ((den[s] >> precision) > 0) {
+                num_virtual[s] = words_per_renorm;
+                den[s] >>= renorm_bits;
             }
         }
-
-        // Second Run: Trace back to fill each probability interval.
-        den = 0;
-        uint64_t tmp;
+        // Checkpoints after the last probability interval, i.e. before tuples without any, read
+        // nothing more from the block.
+        const size_t num_inner_checkpoints = next_checkpoint;
+        for (; next_checkpoint < num_checkpoints; ++next_checkpoint) {
+            DecoderCheckpoint &checkpoint = (*checkpoints)[next_checkpoint];
+            checkpoint = DecoderCheckpoint();
+            checkpoint.interval_ = static_cast<uint32_t>(interval_size);
+            checkpoint.num_words_ = num_words;
+            for (int k = 0; k < num_states; ++k) checkpoint.den_[k] = 1;
+        }
+        next_checkpoint = num_inner_checkpoints;
+
+        // Second Run: Trace back to fill each probability interval. Every state
+        // is traced back independently, while non-virtual words are emitted in
+        // interval order. Virtual words of one renormalization are collected in
+        // stash, the earliest word takes the highest bits. If a block ends in the
+        // middle of a renormalization, the missing words are zeros.
+        uint64_t stash[kMaxInterleavedStates];
+        int num_stashed[kMaxInterleavedStates];
+        for (int s = 0; s < num_states; ++s) {
+            den[s] = 0;
+            stash[s] = 0;
+            num_stashed[s] = num_virtual[s] % words_per_renorm;
+        }
         uint64_t data;
 
         for (int i = interval_size - 1; i >= 0; --i) {
+            const int s = i & state_mask;
             // data = den % w
             // den = den / w
-            tmp = den;
-            den /= prob_intervals[i]->total_weights_;
-            data = tmp - den * prob_intervals[i]->total_weights_;
+            den[s] = prob_intervals[i]->DivMod(den[s], &data);
 
-            const uint16_t byte = GetEmbeddedBytes(prob_intervals[i], data);
+            const uint16_t byte = prob_intervals[i]->Embed(data);
 
-            if (sym_is_virtual[i])
-                den = (den << 16) | byte;
-            else
+            if (sym_is_virtual[i]) {
+                stash[s] |= static_cast<uint64_t>(byte) << (num_stashed[s] << 4);
+                if (++num_stashed[s] == words_per_renorm) {
+                    den[s] = (den[s] << renorm_bits) | stash[s];
+                    stash[s] = 0;
+                    num_stashed[s] = 0;
+                }
+            } else {
                 bit_string->PushAhead(byte);
+            }
+
+            // Every probability interval from the checkpoint on is traced back, so den is the
+            // decoder's num there. A renormalization whose virtual words are all ahead has been
+            // merged into den, otherwise the stash holds the words ahead.
+            while (next_checkpoint > 0 && (*checkpoint_intervals)[next_checkpoint - 1] == i) {
+                DecoderCheckpoint &checkpoint = (*checkpoints)[--next_checkpoint];
+                for (int k = 0; k < num_states; ++k) {
+                    uint64_t num = den[k], bits = 0;
+                    int num_bits = 0;
+                    if (checkpoint.num_virtual_[k] > 0 && num_stashed[k] == 0) {
+                        num_bits = renorm_bits;
+                        bits = num & ((static_cast<uint64_t>(1) << num_bits) - 1);
+                        num >>= renorm_bits;
+                    } else if (checkpoint.num_virtual_[k] > 0) {
+                        num_bits = num_stashed[k] << 4;
+                        bits = stash[k] & ((static_cast<uint64_t>(1) << num_bits) - 1);
+                    }
+                    checkpoint.num_[k] = num;
+                    checkpoint.virtual_bits_[k] = static_cast<uint32_t>(bits << (32 - num_bits));
+                }
+            }
+        }
+    }
+
+    void RansCoding(const std::vector<Branch *> &prob_intervals, int interval_size,
+                    BitString *bit_string, const DelayedCodingConfig &config) {
+        if (!config.IsValid())
+            throw BlitzcrankException("RansCoding::Unsupported rANS engine.\n");
+
+        bit_string->num_ = 0;
+        const int state_mask = config.num_states_ - 1;
+        uint64_t state[kMaxInterleavedStates];
+        for (int s = 0; s < config.num_states_; ++s) state[s] = kRansLowerBound;
+
+        // Trace back like DelayedCoding. Words are pushed ahead, so the decoder
+        // reads them in reversed order: the high half of a renormalization first.
+        uint64_t data;
+        for (int i = interval_size - 1; i >= 0; --i) {
+            const int s = i & state_mask;
+            const Branch *branch = prob_intervals[i];
+            assert(branch->total_weights_ > 0);
+
+            // keep state / w * 2^16 below 2^64
+            uint64_t x = state[s];
+            if ((x >> 48) >= branch->total_weights_) {
+                bit_string->PushAhead(static_cast<uint16_t>(x));
+                bit_string->PushAhead(static_cast<uint16_t>(x >> 16));
+                x >>= 32;
+            }
+            x = branch->DivMod(x, &data);
+            x = (x << 16) | branch->Embed(data);
+
+            // the first probability interval of a state, flush the state
+            if (i <= state_mask)
+                for (int k = 0; k < 64; k += 16) bit_string->PushAhead(static_cast<uint16_t>(x >> k));
+            state[s] = x;
         }
     }
 
@@ -272,34 +366,97 @@ namespace db_compress {
 
     bool DoubleGreaterEqualThan(double a, double b) { return a > (b - 1e-8); }
 
-    void Write(const std::vector<BiMap> &data) {
-        // std::string enum_name = std::to_string(getpid()) + "_enum.dat";
-        std::string enum_name = "_enum.dat";
-        std::ofstream f(enum_name);
-
+    void WriteEnumDictionaries(const std::vector<BiMap> &data, SequenceByteWriter *byte_writer) {
+        byte_writer->Write32Bit(data.size());
         for (const BiMap &map: data) {
+            byte_writer->Write32Bit(map.enums.size());
             for (const std::string &s: map.enums) {
-                f << s << ",";
+                byte_writer->Write32Bit(s.size());
+                for (char c: s) byte_writer->WriteByte(c);
             }
-            f << "\n";
         }
     }
 
-    void Read(std::vector<BiMap> &data) {
-        // std::string enum_name = std::to_string(getpid()) + "_enum.dat";
-        std::string enum_name = "_enum.dat";
-        std::ifstream f(enum_name);
-        std::string s;
-        for (BiMap &map: data) {
-            std::getline(f, s);
-            if (s.back() == '\r') s.pop_back();
-
-            std::stringstream ss(s);
-            std::string item;
-            while (std::getline(ss, item, ',')) {
-                map.enums.push_back(item);
-                map.enum2idx[item] = map.enums.size() - 1;
+    void ReadEnumDictionaries(ByteReader *byte_reader, std::vector<BiMap> *data) {
+        data->assign(byte_reader->ReadUint32(), BiMap());
+        for (BiMap &map: *data) {
+            uint32_t num_enums = byte_reader->ReadUint32();
+            map.enums.resize(num_enums);
+            for (uint32_t i = 0; i < num_enums; ++i) {
+                std::string &s = map.enums[i];
+                s.resize(byte_reader->ReadUint32());
+                for (char &c: s) c = static_cast<char>(byte_reader->ReadByte());
+                map.enum2idx[s] = static_cast<int>(i);
+            }
+        }
+    }
+
+    namespace {
+        size_t VarintLength(uint64_t val) {
+            size_t len = 1;
+            for (; val >= 0x80; val >>= 7) ++len;
+            return len;
+        }
+
+        // The first varint is 0 for dense weights, or (number of non-zero weights << 1) | 1 for
+        // sparse weights.
+        bool IsSparse(const std::vector<unsigned int> &weights, size_t *length) {
+            size_t dense = 1, sparse = 0, num_nonzero = 0, zeros = 0;
+            for (unsigned int weight: weights) {
+                dense += VarintLength(weight);
+                if (weight == 0) {
+                    ++zeros;
+                    continue;
+                }
+                sparse += VarintLength(zeros) + VarintLength(weight);
+                zeros = 0;
+                ++num_nonzero;
             }
+            sparse += VarintLength((num_nonzero << 1) | 1);
+            *length = std::min(dense, sparse);
+            return sparse < dense;
+        }
+    }  // anonymous namespace
+
+    void WriteWeights(const std::vector<unsigned int> &weights, SequenceByteWriter *byte_writer) {
+        size_t length;
+        if (!IsSparse(weights, &length)) {
+            byte_writer->WriteVarint(0);
+            for (unsigned int weight: weights) byte_writer->WriteVarint(weight);
+            return;
+        }
+        size_t num_nonzero = 0;
+        for (unsigned int weight: weights) num_nonzero += (weight != 0);
+        byte_writer->WriteVarint((num_nonzero << 1) | 1);
+        size_t zeros = 0;
+        for (unsigned int weight: weights) {
+            if (weight == 0) {
+                ++zeros;
+                continue;
+            }
+            byte_writer->WriteVarint(zeros);
+            byte_writer->WriteVarint(weight);
+            zeros = 0;
+        }
+    }
+
+    size_t GetWeightsLength(const std::vector<unsigned int> &weights) {
+        size_t length;
+        IsSparse(weights, &length);
+        return length;
+    }
+
+    void ReadWeights(ByteReader *byte_reader, std::vector<unsigned int> *weights) {
+        uint64_t head = byte_reader->ReadVarint();
+        if (!(head & 1)) {
+            for (unsigned int &weight: *weights) weight = byte_reader->ReadVarint();
+            return;
+        }
+        std::fill(weights->begin(), weights->end(), 0);
+        size_t pos = 0;
+        for (uint64_t i = 0; i < (head >> 1); ++i) {
+            pos += byte_reader->ReadVarint();
+            (*weights)[pos++] = byte_reader->ReadVarint();
         }
     }
 }  // namespace db_compress
@@ -9,13 +9,11 @@ class Index {
 public:
   std::vector<uint64_t> index_;
 
-  explicit Index(std::vector<uint8_t> &stream_) {
+  Index(const uint8_t *data, size_t size) {
     index_.resize(1, 0);
-    uint64_t num_byte = 0;
-    for (char c : stream_) {
-      num_byte++;
-      if (c == '\n')
-        index_.push_back(num_byte);
+    for (size_t num_byte = 0; num_byte < size; num_byte++) {
+      if (data[num_byte] == '\n')
+        index_.push_back(num_byte + 1);
     }
   }
 
@@ -35,7 +33,7 @@ int main(int argc, char **argv) {
 
   // Index Construction.
   db_compress::ByteReader reader(file_name);
-  Index index(reader.stream_);
+  Index index(reader.Data(), reader.Size());
   uint32_t num_tuples = index.index_.size();
 
   // Seed Generator
@@ -6,15 +6,18 @@
 #include <string>
 
 #include <categorical_model.h>
+#include <codec.h>
 #include <compression.h>
 #include <decompression.h>
-// #include <markov_model.h>
+#include <markov_model.h>
 #include <csignal>
 #include <model.h>
 #include <numerical_model.h>
 #include <string_model.h>
 #include <unistd.h>
 
+#include "arithmetic_coding/include/arithmetic_codec.h"
+
 class SimpleCategoricalInterpreter : public db_compress::AttrInterpreter {
 private:
     int cap_;
@@ -46,6 +49,12 @@ std::vector<db_compress::BiMap> enum_map;
 char delimiter = ',';
 bool skip_learning = true;
 int block_size = 20000;
+int num_threads = 1;
+db_compress::DelayedCodingConfig coding_config;
+// 0 means picking precision by renormalization width
+int precision = 0;
+// budget of the decoded block cache of random access, in MB
+size_t block_cache_mb = 0;
 
 // -------------------------- Helper Functions ---------------------------
 
@@ -71,13 +80,89 @@ std::ifstream::pos_type filesize(const char *filename) {
 
 void PrintHelpInfo() {
     std::cout << "Compression How To:\n\n";
-    std::cout << "./tabular_blitzcrank [mode] [dataset] [config] [if use \"|\" as delimiter] [if skip learning] [block size]\n\n";
+    std::cout << "./tabular_blitzcrank [mode] [dataset] [config] [if use \"|\" as delimiter] [if skip learning] [block size] [threads] [states] [precision] [renorm bits] [backend] [index image] [checkpoint]\n\n";
     std::cout << "    [mode]: -c for compression, -d for decompression, -b for benchmarking\n";
     std::cout << "    [dataset]: path to the dataset\n";
     std::cout << "    [config]: path to the config file\n";
     std::cout << "    [if use \"|\" as delimiter]: 0 for comma, 1 for \"|\"\n";
     std::cout << "    [if skip learning]: 0 for learning, 1 for skipping learning\n";
     std::cout << "    [block size]: block size for compression\n";
+    std::cout << "    [threads]: optional, number of compression/decompression threads, 1 by default\n";
+    std::cout << "    [states]: optional, number of interleaved coding states (1, 2, 4 or 8), 1 by default\n";
+    std::cout << "    [precision]: optional, delayed coding precision in [16, 48], 16 for random access, 24 (default) for ratio\n";
+    std::cout << "    [renorm bits]: optional, 16 (default) or 32 bits per renormalization, 32 needs precision >= 32 (48 by default)\n";
+    std::cout << "    [backend]: optional, 0 for delayed coding (default), 1 for interleaved rANS, 2 for arithmetic coding\n";
+    std::cout << "    [index image]: optional, 1 to append lookup tables of blocks that are used in place when opening, 0 by default\n";
+    std::cout << "    [checkpoint]: optional, record a decoder checkpoint every this many tuples of a block for random access, 0 (none) by default, not for rANS\n";
+    std::cout << "\nRandom Access How To:\n\n";
+    std::cout << "./tabular_blitzcrank -ra [dataset] [config] [if use \"|\" as delimiter] [if skip learning] [block size] [block cache] [checkpoint]\n\n";
+    std::cout << "    [block cache]: optional, MB of decoded blocks kept for random access, 0 (no cache) by default\n";
+    std::cout << "    [checkpoint]: optional, as for compression\n";
+}
+
+void PrintCodingConfig(const db_compress::DelayedCodingConfig &engine) {
+    if (engine.backend_ == kArithmeticCodingBackend) {
+        std::cout << "Backend: Arithmetic Coding\t" << std::endl;
+        return;
+    }
+    if (engine.backend_ == kRansBackend) {
+        std::cout << "Backend: rANS\t"
+                  << "States: " << engine.num_states_ << "\t" << std::endl;
+        return;
+    }
+    std::cout << "Backend: Delayed Coding\t"
+              << "States: " << engine.num_states_ << "\t"
+              << "Precision: " << engine.precision_ << "\t"
+              << "Renorm Bits: " << engine.renorm_bits_ << "\t" << std::endl;
+}
+
+// Arithmetic coding has no engine params, any other engine is checked by the delayed coding config.
+bool IsValidEngine(const db_compress::DelayedCodingConfig &engine) {
+    return engine.backend_ == kArithmeticCodingBackend || engine.IsValid();
+}
+
+// Create the compressor of an engine.
+std::unique_ptr<db_compress::TupleCompressor> CreateCompressor(const db_compress::DelayedCodingConfig &engine) {
+    if (engine.backend_ == kArithmeticCodingBackend)
+        return std::make_unique<db_compress::arith::ArithmeticCompressor>(output_file_name, schema, config,
+                                                                          block_size);
+    return std::make_unique<db_compress::RelationCompressor>(output_file_name, schema, config, block_size,
+                                                             engine);
+}
+
+// Create the decompressor of a compressed file by its codec id.
+std::unique_ptr<db_compress::TupleDecompressor> CreateDecompressor(const char *file_name) {
+    if (db_compress::ReadCodecId(file_name) == kArithmeticCodingBackend)
+        return std::make_unique<db_compress::arith::ArithmeticDecompressor>(file_name, schema, block_size);
+    return std::make_unique<db_compress::RelationDecompressor>(file_name, schema, block_size);
+}
+
+// Engines compared by benchmarking: the requested one first, then the other delayed coding
+// renormalization widths and rANS, all with the same number of states, and arithmetic coding if
+// it supports the schema.
+std::vector<db_compress::DelayedCodingConfig> GetBenchmarkEngines() {
+    std::vector<db_compress::DelayedCodingConfig> engines{coding_config};
+    db_compress::DelayedCodingConfig engine = coding_config;
+    engine.backend_ = kDelayedCodingBackend;
+    for (int renorm_bits : {kRenormBits, 32}) {
+        if (coding_config.backend_ == kDelayedCodingBackend && coding_config.renorm_bits_ == renorm_bits)
+            continue;
+        engine.renorm_bits_ = renorm_bits;
+        engine.precision_ = renorm_bits == 32 ? kMaxDelayedCoding : kDelayedCoding;
+        engines.push_back(engine);
+    }
+    if (coding_config.backend_ != kRansBackend) {
+        engine = coding_config;
+        engine.backend_ = kRansBackend;
+        engine.checkpoint_tuples_ = 0;
+        engines.push_back(engine);
+    }
+    if (coding_config.backend_ != kArithmeticCodingBackend && db_compress::arith::IsSupportedSchema(schema)) {
+        engine = coding_config;
+        engine.backend_ = kArithmeticCodingBackend;
+        engines.push_back(engine);
+    }
+    return engines;
 }
 
 // Read input_file_name, output_file_name, config_file_name and whether to
@@ -111,9 +196,24 @@ bool ReadParameter(int argc, char **argv) {
                 delimiter = '|';
             skip_learning = std::stoi(argv[6]);
             block_size = std::stoi(argv[7]);
+            if (argc > 8)
+                num_threads = std::stoi(argv[8]);
+            if (argc > 9)
+                coding_config.num_states_ = std::stoi(argv[9]);
+            if (argc > 10)
+                precision = std::stoi(argv[10]);
+            if (argc > 11)
+                coding_config.renorm_bits_ = std::stoi(argv[11]);
+            if (argc > 12)
+                coding_config.backend_ = std::stoi(argv[12]);
+            if (argc > 13)
+                coding_config.index_image_ = std::stoi(argv[13]) == 1;
+            if (argc > 14)
+                coding_config.checkpoint_tuples_ = std::stoi(argv[14]);
             std::cout << "Delimiter: " << delimiter << "\t"
                       << "Skip Learning: " << skip_learning << "\t"
-                      << "Block Size: " << block_size << "\t" << std::endl;
+                      << "Block Size: " << block_size << "\t"
+                      << "Threads: " << num_threads << "\t" << std::endl;
         }
             break;
         case DECOMPRESS: {
@@ -126,8 +226,11 @@ bool ReadParameter(int argc, char **argv) {
             if (special_del == 1)
                 delimiter = '|';
             block_size = std::stoi(argv[6]);
+            if (argc > 7)
+                num_threads = std::stoi(argv[7]);
             std::cout << "Delimiter: " << delimiter << "\t"
-                      << "Block Size: " << block_size << "\t" << std::endl;
+                      << "Block Size: " << block_size << "\t"
+                      << "Threads: " << num_threads << "\t" << std::endl;
         }
             break;
         case BENCHMARK: {
@@ -137,16 +240,31 @@ bool ReadParameter(int argc, char **argv) {
             std::string com = std::to_string(getpid()) + "_file.com";
             strcpy(output_file_name, com.c_str());
             strcpy(config_file_name, argv[3]);
-            if (argc == 7) {
+            if (argc >= 7) {
                 int special_del = std::stoi(argv[4]);
                 if (special_del == 1)
                     delimiter = '|';
                 skip_learning = std::stoi(argv[5]);
                 block_size = std::stoi(argv[6]);
             }
+            if (argc >= 8)
+                num_threads = std::stoi(argv[7]);
+            if (argc >= 9)
+                coding_config.num_states_ = std::stoi(argv[8]);
+            if (argc >= 10)
+                precision = std::stoi(argv[9]);
+            if (argc >= 11)
+                coding_config.renorm_bits_ = std::stoi(argv[10]);
+            if (argc >= 12)
+                coding_config.backend_ = std::stoi(argv[11]);
+            if (argc >= 13)
+                coding_config.index_image_ = std::stoi(argv[12]) == 1;
+            if (argc >= 14)
+                coding_config.checkpoint_tuples_ = std::stoi(argv[13]);
             std::cout << "Delimiter: " << delimiter << "\t"
                       << "Skip Learning: " << skip_learning << "\t"
-                      << "Block Size: " << block_size << "\t" << std::endl;
+                      << "Block Size: " << block_size << "\t"
+                      << "Threads: " << num_threads << "\t" << std::endl;
             break;
         }
         case RANDOM_ACCESS: {
@@ -161,12 +279,30 @@ bool ReadParameter(int argc, char **argv) {
                 delimiter = '|';
             skip_learning = std::stoi(argv[5]);
             block_size = std::stoi(argv[6]);
+            if (argc > 7)
+                block_cache_mb = std::stoul(argv[7]);
+            if (argc > 8)
+                coding_config.checkpoint_tuples_ = std::stoi(argv[8]);
             std::cout << "Delimiter: " << delimiter << "\t"
                       << "Skip Learning: " << skip_learning << "\t"
-                      << "Block Size: " << block_size << "\t" << std::endl;
+                      << "Block Size: " << block_size << "\t"
+                      << "Block Cache: " << block_cache_mb << " MB\t" << std::endl;
         }
             break;
     }
+    if (precision > 0)
+        coding_config.precision_ = precision;
+    else
+        coding_config.precision_ = coding_config.renorm_bits_ == 32 ? kMaxDelayedCoding : kDelayedCoding;
+    if (mode == COMPRESS || mode == BENCHMARK) {
+        if (!IsValidEngine(coding_config)) {
+            std::cout << "Unsupported coding engine: states must be 1, 2, 4 or 8, renorm bits must be "
+                         "16 or 32, precision must be in [max(16, renorm bits), 48], backend must be 0, 1 or 2, "
+                         "and checkpoints need delayed coding." << std::endl;
+            return false;
+        }
+        PrintCodingConfig(coding_config);
+    }
     return true;
 }
 
@@ -256,7 +392,7 @@ void LoadConfig(char *configFileName_) {
     RegisterAttrModel(1, new db_compress::TableNumericalIntCreator());
     RegisterAttrModel(2, new db_compress::TableNumericalRealCreator());
     RegisterAttrModel(3, new db_compress::StringModelCreator());
-    // RegisterAttrModel(5, new db_compress::TableMarkovCreator());
+    RegisterAttrModel(5, new db_compress::TableMarkovCreator());
     // RegisterAttrModel(4, new db_compress::TableTimeSeriesCreator());
 
     if (attr_type.empty()) {
@@ -327,6 +463,25 @@ inline void ExtractAttr(const db_compress::AttrVector &tuple,
     }
 }
 
+// Write record into file.
+void WriteTuple(std::ofstream &out_file, const db_compress::AttrVector &tuple, std::string &str) {
+    for (size_t i = 0; i < schema.size(); ++i) {
+        ExtractAttr(tuple, schema.attr_type_[i], static_cast<int>(i), str);
+        bool has_del = false;
+        for (size_t j = 0; j < str.size(); ++j) {
+            if (str[j] == ',') {
+                out_file << '\"';
+                has_del = true;
+                break;
+            }
+        }
+        out_file << str;
+        if (has_del)
+            out_file << '\"';
+        out_file << (i == schema.size() - 1 ? '\n' : delimiter);
+    }
+}
+
 int LoadDataSet() {
     std::ios::sync_with_stdio(false);
 
@@ -387,9 +542,6 @@ int LoadDataSet() {
         // std::cout << "Load " << datasets.size() << " tuples\n";
     }
 
-    // write down enum attrs.
-    db_compress::Write(enum_map);
-
     std::cout << "Data loaded.\n";
 
     return datasets.size();
@@ -405,11 +557,16 @@ int main(int argc, char **argv) {
         }
         std::ios::sync_with_stdio(false);
         LoadConfig(config_file_name);
+        if (coding_config.backend_ == kArithmeticCodingBackend && !db_compress::arith::IsSupportedSchema(schema)) {
+            std::cerr << "Arithmetic coding supports ENUM, INTEGER, DOUBLE and STRING attributes only, use backend 0 "
+                         "or 1 for ENUM-MARKOV and TIMESERIES." << std::endl;
+            return 1;
+        }
         switch (mode) {
             case COMPRESS: {
-                db_compress::RelationCompressor compressor(output_file_name, schema,
-                                                           config, block_size);
+                std::unique_ptr<db_compress::TupleCompressor> compressor = CreateCompressor(coding_config);
                 int num_total_tuples = LoadDataSet();
+                compressor->SetEnumDictionaries(enum_map);
                 int iter_cnt = 0;
 
                 // random number
@@ -436,68 +593,50 @@ int main(int argc, char **argv) {
                         }
 
                         db_compress::AttrVector &tuple = datasets[tuple_idx];
-                        { compressor.LearnTuple(tuple); }
+                        { compressor->LearnTuple(tuple); }
                         if (tuple_cnt >= kNonFullPassStopPoint &&
-                            !compressor.RequireFullPass()) {
+                            !compressor->RequireFullPass()) {
                             break;
                         }
                     }
-                    compressor.EndOfLearning();
+                    compressor->EndOfLearning();
 
-                    if (!tuning && compressor.RequireFullPass()) {
+                    if (!tuning && compressor->RequireFullPass()) {
                         tuning = true;
                     }
 
-                    if (!compressor.RequireMoreIterationsForLearning()) {
+                    if (!compressor->RequireMoreIterationsForLearning()) {
                         break;
                     }
                 }
 
                 // Compression iteration
                 // std::cout << "Compression Iteration " << ++iter_cnt << " Starts\n";
-                for (int i = 0; i < num_total_tuples; ++i) {
-                    db_compress::AttrVector &tuple = datasets[i];
-                    compressor.CompressTuple(tuple);
-                }
-                compressor.EndOfCompress();
+                compressor->CompressTuples(datasets.begin(), datasets.end(), num_threads);
+                compressor->EndOfCompress();
                 std::cout << "Compressed Size: " << filesize(output_file_name) << "\n";
 
-//                std::string index_file_name = std::to_string(getpid()) + "_temp.index";
-//                std::string enum_file_name = std::to_string(getpid()) + "_enum.dat";
-//                remove(index_file_name.c_str());
-//                remove(enum_file_name.c_str());
             }
                 break;
             case DECOMPRESS: {
-                // Load enum values
-                db_compress::Read(enum_map);
-
                 // Decompress
-                db_compress::RelationDecompressor decompressor(input_file_name, schema,
-                                                               block_size);
+                std::unique_ptr<db_compress::TupleDecompressor> decompressor = CreateDecompressor(input_file_name);
                 std::ofstream out_file(output_file_name);
                 std::string str;
-                decompressor.Init();
+                decompressor->Init();
+                // Load enum values
+                enum_map = decompressor->GetEnumDictionaries();
                 db_compress::AttrVector tuple(static_cast<int>(schema.size()));
 
-                while (decompressor.HasNext()) {
-                    decompressor.ReadNextTuple(&tuple);
-
-                    // Write record into file.
-                    for (size_t i = 0; i < schema.size(); ++i) {
-                        ExtractAttr(tuple, schema.attr_type_[i], static_cast<int>(i), str);
-                        bool has_del = false;
-                        for (size_t j = 0; j < str.size(); ++j) {
-                            if (str[j] == ',') {
-                                out_file << '\"';
-                                has_del = true;
-                                break;
-                            }
-                        }
-                        out_file << str;
-                        if (has_del)
-                            out_file << '\"';
-                        out_file << (i == schema.size() - 1 ? '\n' : delimiter);
+                if (num_threads > 1) {
+                    std::vector<db_compress::AttrVector> tuples;
+                    decompressor->ReadAllTuples(&tuples, num_threads);
+                    for (const db_compress::AttrVector &record: tuples)
+                        WriteTuple(out_file, record, str);
+                } else {
+                    while (decompressor->HasNext()) {
+                        decompressor->ReadNextTuple(&tuple);
+                        WriteTuple(out_file, tuple, str);
                     }
                 }
                 out_file.close();
@@ -505,123 +644,121 @@ int main(int argc, char **argv) {
                 break;
             case BENCHMARK: {
                 int origin_size = filesize(input_file_name);
-                {
-                    // Compress
-                    std::cout << "[Compression]\t";
-                    db_compress::RelationCompressor compressor(output_file_name, schema,
-                                                               config, block_size);
-                    int num_total_tuples = LoadDataSet();
-
-                    // random number
-                    std::random_device random_device;
-                    std::mt19937 mt19937(0);
-                    std::uniform_int_distribution<uint32_t> dist(0, num_total_tuples - 1);
-                    bool tuning = false;
-
-                    // Learning Iterations
-                    while (true) {
-                        int tuple_cnt = 0;
-                        int tuple_random_cnt = 0;
-                        int tuple_idx;
+                int num_total_tuples = LoadDataSet();
+                for (const db_compress::DelayedCodingConfig &engine : GetBenchmarkEngines()) {
+                    std::cout << "[Engine]\t";
+                    PrintCodingConfig(engine);
+                    {
+                        // Compress
+                        std::cout << "[Compression]\t";
+                        std::unique_ptr<db_compress::TupleCompressor> compressor = CreateCompressor(engine);
+                        compressor->SetEnumDictionaries(enum_map);
+
+                        // random number
+                        std::random_device random_device;
+                        std::mt19937 mt19937(0);
+                        std::uniform_int_distribution<uint32_t> dist(0, num_total_tuples - 1);
+                        bool tuning = false;
+
+                        // Learning Iterations
+                        while (true) {
+                            int tuple_cnt = 0;
+                            int tuple_random_cnt = 0;
+                            int tuple_idx;
+
+                            while (tuple_cnt < num_total_tuples) {
+                                if (tuple_random_cnt < kNumEstSample) {
+                                    tuple_idx = static_cast<int>(dist(mt19937));
+                                    tuple_random_cnt++;
+                                } else {
+                                    tuple_idx = tuple_cnt;
+                                    tuple_cnt++;
+                                }
+
+                                db_compress::AttrVector &tuple = datasets[tuple_idx];
+                                { compressor->LearnTuple(tuple); }
+                                if (tuple_cnt >= kNonFullPassStopPoint &&
+                                    !compressor->RequireFullPass()) {
+                                    break;
+                                }
+                            }
+                            compressor->EndOfLearning();
 
-                        while (tuple_cnt < num_total_tuples) {
-                            if (tuple_random_cnt < kNumEstSample) {
-                                tuple_idx = static_cast<int>(dist(mt19937));
-                                tuple_random_cnt++;
-                            } else {
-                                tuple_idx = tuple_cnt;
-                                tuple_cnt++;
+                            if (!tuning && compressor->RequireFullPass()) {
+                                tuning = true;
                             }
 
-                            db_compress::AttrVector &tuple = datasets[tuple_idx];
-                            { compressor.LearnTuple(tuple); }
-                            if (tuple_cnt >= kNonFullPassStopPoint &&
-                                !compressor.RequireFullPass()) {
+                            if (!compressor->RequireMoreIterationsForLearning()) {
                                 break;
                             }
                         }
-                        compressor.EndOfLearning();
 
-                        if (!tuning && compressor.RequireFullPass()) {
-                            tuning = true;
-                        }
-
-                        if (!compressor.RequireMoreIterationsForLearning()) {
-                            break;
-                        }
+                        // Compression iteration
+                        // std::cout << "Compression Iteration " << ++iter_cnt << " Starts\n";
+                        auto compression_start = std::chrono::system_clock::now();
+                        compressor->CompressTuples(datasets.begin(), datasets.end(), num_threads);
+                        compressor->EndOfCompress();
+                        auto compression_end = std::chrono::system_clock::now();
+                        auto compression_duration =
+                                std::chrono::duration_cast<std::chrono::microseconds>(
+                                        compression_end - compression_start);
+                        std::cout << "Throughput:  "
+                                  << origin_size / 1024 / 1024 /
+                                     (static_cast<double>(compression_duration.count()) *
+                                      std::chrono::microseconds::period::num /
+                                      std::chrono::microseconds::period::den)
+                                  << " MiB/s\t";
+                        std::cout << "Time:  "
+                                  << static_cast<double>(compression_duration.count()) *
+                                     std::chrono::microseconds::period::num /
+                                     std::chrono::microseconds::period::den
+                                  << " s\n";
                     }
-
-                    // Compression iteration
-                    // std::cout << "Compression Iteration " << ++iter_cnt << " Starts\n";
-                    auto compression_start = std::chrono::system_clock::now();
-                    for (int i = 0; i < num_total_tuples; ++i) {
-                        db_compress::AttrVector &tuple = datasets[i];
-                        compressor.CompressTuple(tuple);
+                    {
+                        // Decompress
+                        std::cout << "[Decompression]\t";
+                        std::unique_ptr<db_compress::TupleDecompressor> decompressor =
+                                CreateDecompressor(output_file_name);
+                        decompressor->Init();
+                        db_compress::AttrVector tuple(static_cast<int>(schema.size()));
+                        auto decompress_start = std::chrono::system_clock::now();
+                        if (num_threads > 1)
+                            decompressor->ParallelScan(num_threads, [](int, size_t, const db_compress::AttrVector &) {});
+                        else
+                            while (decompressor->HasNext())
+                                decompressor->ReadNextTuple(&tuple);
+
+                        auto decompress_end = std::chrono::system_clock::now();
+                        auto decompress_duration =
+                                std::chrono::duration_cast<std::chrono::microseconds>(
+                                        decompress_end - decompress_start);
+                        std::cout << "Throughput:  "
+                                  << origin_size / 1024 / 1024 /
+                                     (static_cast<double>(decompress_duration.count()) *
+                                      std::chrono::microseconds::period::num /
+                                      std::chrono::microseconds::period::den)
+                                  << " MiB/s\t";
+                        std::cout << "Time:  "
+                                  << static_cast<double>(decompress_duration.count()) *
+                                     std::chrono::microseconds::period::num /
+                                     std::chrono::microseconds::period::den
+                                  << " s\n";
                     }
-                    compressor.EndOfCompress();
-                    auto compression_end = std::chrono::system_clock::now();
-                    auto compression_duration =
-                            std::chrono::duration_cast<std::chrono::microseconds>(
-                                    compression_end - compression_start);
-                    std::cout << "Throughput:  "
-                              << origin_size / 1024 / 1024 /
-                                 (static_cast<double>(compression_duration.count()) *
-                                  std::chrono::microseconds::period::num /
-                                  std::chrono::microseconds::period::den)
-                              << " MiB/s\t";
-                    std::cout << "Time:  "
-                              << static_cast<double>(compression_duration.count()) *
-                                 std::chrono::microseconds::period::num /
-                                 std::chrono::microseconds::period::den
-                              << " s\n";
+                    int compressed_size = filesize(output_file_name);
+                    std::cout << "[Compression Factor (Origin Size / CompressedSize)]: "
+                              << origin_size / (double) compressed_size << "\n";
+                    std::cout << "Compressed Size: " << compressed_size << "\n";
+                    remove(output_file_name);
                 }
-                {
-                    // Decompress
-                    std::cout << "[Decompression]\t";
-                    db_compress::RelationDecompressor decompressor(output_file_name, schema,
-                                                                   block_size);
-                    decompressor.Init();
-                    db_compress::AttrVector tuple(static_cast<int>(schema.size()));
-                    auto decompress_start = std::chrono::system_clock::now();
-                    while (decompressor.HasNext())
-                        decompressor.ReadNextTuple(&tuple);
-
-                    auto decompress_end = std::chrono::system_clock::now();
-                    auto decompress_duration =
-                            std::chrono::duration_cast<std::chrono::microseconds>(
-                                    decompress_end - decompress_start);
-                    std::cout << "Throughput:  "
-                              << origin_size / 1024 / 1024 /
-                                 (static_cast<double>(decompress_duration.count()) *
-                                  std::chrono::microseconds::period::num /
-                                  std::chrono::microseconds::period::den)
-                              << " MiB/s\t";
-                    std::cout << "Time:  "
-                              << static_cast<double>(decompress_duration.count()) *
-                                 std::chrono::microseconds::period::num /
-                                 std::chrono::microseconds::period::den
-                              << " s\n";
-                }
-                int compressed_size = filesize(output_file_name);
-                std::cout << "[Compression Factor (Origin Size / CompressedSize)]: "
-                          << origin_size / (double) compressed_size << "\n";
-                std::cout << "Compressed Size: " << compressed_size << "\n";
-                remove(output_file_name);
-//                std::string index_file_name = std::to_string(getpid()) + "_temp.index";
-//                std::string enum_file_name = std::to_string(getpid()) + "_enum.dat";
-                std::string index_file_name = "_temp.index";
-                std::string enum_file_name = "_enum.dat";
-                remove(index_file_name.c_str());
-                remove(enum_file_name.c_str());
             }
                 break;
             case RANDOM_ACCESS: {
                 //
                 {
                     // compress first
-                    db_compress::RelationCompressor compressor(output_file_name, schema,
-                                                               config, block_size);
+                    std::unique_ptr<db_compress::TupleCompressor> compressor = CreateCompressor(coding_config);
                     int num_total_tuples = LoadDataSet();
+                    compressor->SetEnumDictionaries(enum_map);
                     int iter_cnt = 0;
 
                     // random number
@@ -648,19 +785,19 @@ int main(int argc, char **argv) {
                             }
 
                             db_compress::AttrVector &tuple = datasets[tuple_idx];
-                            { compressor.LearnTuple(tuple); }
+                            { compressor->LearnTuple(tuple); }
                             if (tuple_cnt >= kNonFullPassStopPoint &&
-                                !compressor.RequireFullPass()) {
+                                !compressor->RequireFullPass()) {
                                 break;
                             }
                         }
-                        compressor.EndOfLearning();
+                        compressor->EndOfLearning();
 
-                        if (!tuning && compressor.RequireFullPass()) {
+                        if (!tuning && compressor->RequireFullPass()) {
                             tuning = true;
                         }
 
-                        if (!compressor.RequireMoreIterationsForLearning()) {
+                        if (!compressor->RequireMoreIterationsForLearning()) {
                             break;
                         }
                     }
@@ -669,9 +806,9 @@ int main(int argc, char **argv) {
                     // std::cout << "Compression Iteration " << ++iter_cnt << " Starts\n";
                     for (int i = 0; i < num_total_tuples; ++i) {
                         db_compress::AttrVector &tuple = datasets[i];
-                        compressor.CompressTuple(tuple);
+                        compressor->CompressTuple(tuple);
                     }
-                    compressor.EndOfCompress();
+                    compressor->EndOfCompress();
                     std::cout << "Compressed Size: " << filesize(output_file_name) << "\n";
                 }
 
@@ -680,11 +817,11 @@ int main(int argc, char **argv) {
                 std::cout << "[Random Access Test]\t";
                 std::cout << "Note that in this test, number of tuple in a block should "
                              "be only ONE.\n";
+                std::unique_ptr<db_compress::TupleDecompressor> decompressor = CreateDecompressor(output_file_name);
+                decompressor->Init();
+                decompressor->SetBlockCache(block_cache_mb << 20);
                 // Load enum values
-                db_compress::Read(enum_map);
-                db_compress::RelationDecompressor decompressor(output_file_name, schema,
-                                                               block_size);
-                decompressor.Init();
+                enum_map = decompressor->GetEnumDictionaries();
                 db_compress::AttrVector tuple(static_cast<int>(schema.size()));
 
 #if DEBUG == 1
@@ -697,7 +834,7 @@ int main(int argc, char **argv) {
                 std::random_device random_device;
                 std::mt19937 mt19937(0);
                 std::uniform_int_distribution<uint32_t> dist(
-                        0, decompressor.num_total_tuples_ - 1);
+                        0, decompressor->GetNumTotalTuples() - 1);
                 size_t size = 300000;
                 std::vector<uint32_t> tuple_indices(size);
                 for (size_t i = 0; i < size; i++) {
@@ -709,14 +846,14 @@ int main(int argc, char **argv) {
                 auto start = std::chrono::system_clock::now();
                 for (int idx: tuple_indices) {
 #if DEBUG == 0
-                    // decompressor.ReadTargetTuple(idx, &tuple);
-                    decompressor.LocateTuple(idx);
-                    while (decompressor.HasNext())
-                        decompressor.ReadNextTuple(&tuple);
+                    // decompressor->ReadTargetTuple(idx, &tuple);
+                    decompressor->LocateTuple(idx);
+                    while (decompressor->HasNext())
+                        decompressor->ReadNextTuple(&tuple);
 #else
-                    decompressor.LocateTuple(idx);
-                    while (decompressor.HasNext())
-                      decompressor.ReadNextTuple(&tuple);
+                    decompressor->LocateTuple(idx);
+                    while (decompressor->HasNext())
+                      decompressor->ReadNextTuple(&tuple);
 #endif
 
 #if DEBUG
@@ -735,11 +872,27 @@ int main(int argc, char **argv) {
                              std::chrono::microseconds::period::num /
                              std::chrono::microseconds::period::den / (int) size * 1e6
                           << " us\n";
+                if (block_cache_mb > 0) {
+                    db_compress::BlockCacheStats stats = decompressor->GetBlockCacheStats();
+                    std::cout << "Block Cache Hits: " << stats.hits_ << "\tMisses: " << stats.misses_ << "\n";
+                }
+#if DEBUG == 0
+                // the same lookups, batched with ReadTuples()
+                const size_t batch_size = 1000;
+                std::vector<db_compress::AttrVector> tuples(batch_size, tuple);
+                start = std::chrono::system_clock::now();
+                for (size_t i = 0; i < size; i += batch_size)
+                    decompressor->ReadTuples(tuple_indices.data() + i, std::min(batch_size, size - i),
+                                             tuples.data());
+                end = std::chrono::system_clock::now();
+                duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+                std::cout << "Time (batches of " << batch_size << "):  "
+                          << static_cast<double>(duration.count()) *
+                             std::chrono::microseconds::period::num /
+                             std::chrono::microseconds::period::den / (int) size * 1e6
+                          << " us\n";
+#endif
                 std::cout << "-------------------------------------------------------" << std::endl;
-                std::string index_file_name = std::to_string(getpid()) + "_temp.index";
-                std::string enum_file_name = std::to_string(getpid()) + "_enum.dat";
-                remove(index_file_name.c_str());
-                remove(enum_file_name.c_str());
                 remove(output_file_name);
             }
                 break;
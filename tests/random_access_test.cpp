@@ -0,0 +1,136 @@
+/**
+ * @file random_access_test.cpp
+ * @brief Random access must decode the same tuples as a full scan, for models that carry state
+ * from one tuple to the next one, i.e. markov enums and local string dictionaries.
+ */
+
+#include <categorical_model.h>
+#include <compression.h>
+#include <decompression.h>
+#include <markov_model.h>
+#include <numerical_model.h>
+#include <string_model.h>
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+using db_compress::AttrVector;
+
+constexpr int kNumTuples = 3000;
+constexpr int kNumLookups = 2000;
+constexpr double kDoubleErr = 0.01;
+
+class EnumInterpreter : public db_compress::AttrInterpreter {
+ public:
+  bool EnumInterpretable() const override { return true; }
+  int EnumCap() const override { return 10; }
+  size_t EnumInterpret(const db_compress::AttrValue &attr) const override { return attr.Int(); }
+};
+
+// A markov enum, an integer, a double and a string drawn from a few recent values.
+std::vector<AttrVector> MakeTuples() {
+  std::vector<AttrVector> tuples;
+  std::vector<std::string> recent;
+  std::mt19937 rand(1);
+  for (int i = 0; i < kNumTuples; ++i) {
+    AttrVector tuple(4);
+    int state = i == 0 ? 0 : (tuples.back().attr_[0].Int() + 1 + (rand() % 8 == 0)) % 10;
+    tuple.attr_[0].value_ = state;
+    tuple.attr_[1].value_ = static_cast<int>(rand() % 1000) + state * 3;
+    tuple.attr_[2].value_ = static_cast<double>(rand() % 10000) / 100;
+    std::string word;
+    if (recent.size() > 4 && rand() % 2) {
+      word = recent[recent.size() - 1 - rand() % 4];
+    } else {
+      for (int j = 0; j < 12; ++j) word.push_back(static_cast<char>(33 + rand() % 90));
+    }
+    recent.push_back(word);
+    tuple.attr_[3].value_ = word;
+    tuples.push_back(tuple);
+  }
+  return tuples;
+}
+
+std::vector<unsigned char> Compress(const db_compress::Schema &schema,
+                                    std::vector<AttrVector> tuples) {
+  db_compress::CompressionConfig config;
+  config.allowed_err_ = {0, 0, kDoubleErr, 0};
+  config.skip_model_learning_ = true;
+  std::vector<unsigned char> compressed;
+  db_compress::RelationCompressor compressor(&compressed, schema, config, 1);
+  compressor.SetEnumDictionaries(std::vector<db_compress::BiMap>(schema.size()));
+  std::mt19937 rand(0);
+  while (true) {
+    int tuple_cnt = 0;
+    int random_cnt = 0;
+    while (tuple_cnt < kNumTuples) {
+      int tuple_idx;
+      if (random_cnt < kNumEstSample) {
+        tuple_idx = static_cast<int>(rand() % kNumTuples);
+        ++random_cnt;
+      } else {
+        tuple_idx = tuple_cnt++;
+      }
+      compressor.LearnTuple(tuples[tuple_idx]);
+      if (tuple_cnt >= kNonFullPassStopPoint && !compressor.RequireFullPass()) break;
+    }
+    compressor.EndOfLearning();
+    if (!compressor.RequireMoreIterationsForLearning()) break;
+  }
+  compressor.CompressTuples(tuples.begin(), tuples.end(), 1);
+  compressor.EndOfCompress();
+  return compressed;
+}
+
+// Doubles are lossy, so they are only compared to the ones decoded by a full scan.
+bool SameTuple(const AttrVector &a, const AttrVector &b, bool exact_doubles) {
+  return a.attr_[0].Int() == b.attr_[0].Int() && a.attr_[1].Int() == b.attr_[1].Int() &&
+         (!exact_doubles || a.attr_[2].Double() == b.attr_[2].Double()) &&
+         a.attr_[3].String() == b.attr_[3].String();
+}
+}  // anonymous namespace
+
+int main() {
+  db_compress::RegisterAttrInterpreter(0, new EnumInterpreter());
+  for (int i = 1; i < 4; ++i)
+    db_compress::RegisterAttrInterpreter(i, new db_compress::AttrInterpreter());
+  db_compress::RegisterAttrModel(1, new db_compress::TableNumericalIntCreator());
+  db_compress::RegisterAttrModel(2, new db_compress::TableNumericalRealCreator());
+  db_compress::RegisterAttrModel(3, new db_compress::StringModelCreator());
+  db_compress::RegisterAttrModel(5, new db_compress::TableMarkovCreator());
+  db_compress::Schema schema(std::vector<int>{5, 1, 2, 3});
+
+  std::vector<AttrVector> tuples = MakeTuples();
+  db_compress::RelationDecompressor decompressor(Compress(schema, tuples), schema, 1);
+  decompressor.Init();
+
+  std::vector<AttrVector> scanned;
+  AttrVector tuple(4);
+  while (decompressor.HasNext()) {
+    decompressor.ReadNextTuple(&tuple);
+    if (!SameTuple(tuple, tuples[scanned.size()], false)) {
+      std::cerr << "Full scan decoded a wrong tuple " << scanned.size() << "\n";
+      return 1;
+    }
+    scanned.push_back(tuple);
+  }
+
+  int num_mismatches = 0;
+  std::mt19937 rand(5);
+  for (int i = 0; i < kNumLookups; ++i) {
+    uint32_t tuple_idx = rand() % kNumTuples;
+    decompressor.ReadTargetTuple(tuple_idx, &tuple);
+    if (!SameTuple(tuple, scanned[tuple_idx], true)) ++num_mismatches;
+    decompressor.LocateTuple(tuple_idx);
+    while (decompressor.HasNext()) decompressor.ReadNextTuple(&tuple);
+    if (!SameTuple(tuple, scanned[tuple_idx], true)) ++num_mismatches;
+  }
+  if (num_mismatches > 0) {
+    std::cerr << num_mismatches << " of " << 2 * kNumLookups << " lookups decoded a wrong tuple\n";
+    return 1;
+  }
+  return 0;
+}